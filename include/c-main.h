@@ -85,7 +85,9 @@ void MLton_threadFunc (void* arg) {                                     \
   /* Save our state locally */                                          \
   if (s->procNumber != 0) {                                             \
     pthread_setspecific (gcstate_key, s);                               \
+    GC_profileThreadInit (s);                                           \
   }                                                                     \
+  GC_perfCountersThreadInit (s);                                        \
   if (s->amOriginal) {                                                  \
     nextBlock = ml;                                                     \
   } else {                                                              \
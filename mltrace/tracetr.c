@@ -4,6 +4,7 @@
  * See the file MLton-LICENSE for details.
  */
 
+#include <assert.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -61,6 +62,9 @@ static const char *EventKindStrings[] = {
   [EVENT_MERGED_HEAP]           = "MERGED_HEAP",
 
   [EVENT_COPY]                  = "COPY",
+
+  [EVENT_TRACE_CLOCK]           = "TRACE_CLOCK",
+  [EVENT_TRACE_DROPPED]         = "TRACE_DROPPED",
 };
 
 void processFiles(size_t filecount, FILE **files, void (*func)(struct Event *));
@@ -159,55 +163,251 @@ int main(int argc, char *argv[]) {
   return 0;
 }
 
-#define BUFFER_SIZE 10000
+/* Decoding of the trace format described in trace.h. Raw timestamps are
+ * converted to nanoseconds by interpolating between the EVENT_TRACE_CLOCK
+ * records of each stream, so events are held back until the next clock
+ * record. */
 
-void processFiles(size_t filecount, FILE **files,
-                  void (*func)(struct Event *)) {
-  struct Event events[BUFFER_SIZE];
+struct PendingEvents {
+  struct TraceRecord *records;
+  size_t count;
+  size_t capacity;
+};
 
-  for (size_t i = 0; i < filecount; ++i) {
-    size_t evcount = 0, evbatchsize;
+struct ClockSync {
+  bool valid;
+  uint64_t tsc;
+  uint64_t ns;
+  double rate;
+};
 
-    do {
-      evbatchsize = fread(events, sizeof *events, BUFFER_SIZE,
-                          files[i]);
-      evcount += evbatchsize;
+static bool readVarint(FILE *f, uint64_t *result) {
+  uint64_t v = 0;
+  int c;
+
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if ((c = getc(f)) == EOF)
+      return false;
+    v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *result = v;
+      return true;
+    }
+  }
 
-      for (int j = 0; j < evbatchsize; j++)
-        func(&events[j]);
+  fprintf(stderr, "malformed varint in trace\n");
+  exit(1);
+}
 
-    } while (evbatchsize == BUFFER_SIZE);
+static void pushPending(struct PendingEvents *pending,
+                        const struct TraceRecord *r) {
+  if (pending->count == pending->capacity) {
+    pending->capacity = pending->capacity ? 2 * pending->capacity : 1024;
+    pending->records = realloc(pending->records,
+                               pending->capacity * sizeof *pending->records);
+    if (pending->records == NULL) {
+      fprintf(stderr, "Could not allocate memory\n");
+      exit(1);
+    }
   }
+  pending->records[pending->count++] = *r;
 }
 
-void processFilesChromeTracingJSON(size_t filecount, FILE **files)
-{
-  struct Event events[BUFFER_SIZE];
+static void emitRecord(const struct TraceRecord *r, uint64_t ns,
+                       void (*func)(struct Event *)) {
+  struct Event event;
 
-  printf("[\n");
+  event.kind = r->kind;
+  event.argptr = r->proc;
+  event.ts.tv_sec = ns / 1000000000ULL;
+  event.ts.tv_nsec = ns % 1000000000ULL;
+  event.arg1 = r->arg1;
+  event.arg2 = r->arg2;
+  event.arg3 = r->arg3;
 
-  bool first = true;
+  func(&event);
+}
 
-  for (size_t i = 0; i < filecount; ++i) {
-    size_t evcount = 0, evbatchsize;
+static void emitPending(struct PendingEvents *pending, struct ClockSync *sync,
+                        void (*func)(struct Event *)) {
+  if (!sync->valid && pending->count > 0) {
+    /* No clock record to go by; count from the first event. */
+    sync->tsc = pending->records[0].tsc;
+    sync->ns = 0;
+  }
 
-    do {
-      evbatchsize = fread(events, sizeof *events, BUFFER_SIZE,
-                          files[i]);
-      evcount += evbatchsize;
+  for (size_t i = 0; i < pending->count; i++) {
+    const struct TraceRecord *r = &pending->records[i];
+    double offset = (double)(int64_t)(r->tsc - sync->tsc) * sync->rate;
+    int64_t ns = (int64_t)sync->ns + (int64_t)offset;
 
-      for (int j = 0; j < evbatchsize; j++) {
+    emitRecord(r, ns < 0 ? 0 : (uint64_t)ns, func);
+  }
+  pending->count = 0;
+}
+
+static void syncClock(struct PendingEvents *pending, struct ClockSync *sync,
+                      uint64_t tsc, uint64_t ns,
+                      void (*func)(struct Event *)) {
+  if (!sync->valid) {
+    sync->valid = true;
+    sync->tsc = tsc;
+    sync->ns = ns;
+  } else if (tsc > sync->tsc && ns > sync->ns) {
+    sync->rate = (double)(ns - sync->ns) / (double)(tsc - sync->tsc);
+  }
 
-        if (first) first = false;
-        else printf(",\n");
+  emitPending(pending, sync, func);
 
-        printf("  ");
-        printEventChromeTracingJSON(&events[j]);
+  sync->tsc = tsc;
+  sync->ns = ns;
+}
+
+/* Reads the rest of a stream header, after its magic. */
+static void readStreamHeader(FILE *f, uint32_t *proc) {
+  uint64_t version, p;
+
+  if (!readVarint(f, &version) || !readVarint(f, &p)) {
+    fprintf(stderr, "malformed trace stream header\n");
+    exit(1);
+  }
+
+  if (version != TraceCurrentVersion) {
+    fprintf(stderr, "unsupported trace version %" PRIx64 "\n", version);
+    exit(1);
+  }
+
+  *proc = p;
+}
+
+/* Decode a sequence of streams, as found in a trace file or in the
+ * concatenation of several. The magic of the first stream has already been
+ * consumed. */
+static void decodeStreams(FILE *f, struct PendingEvents *pending,
+                          void (*func)(struct Event *)) {
+  struct ClockSync sync = {false, 0, 0, 1.0};
+  uint64_t lastTsc = 0;
+  uint32_t proc;
+  uint64_t tag;
+
+  readStreamHeader(f, &proc);
+
+  while (readVarint(f, &tag)) {
+    struct TraceRecord r;
+    uint64_t delta;
+    EventInt *args[3] = {&r.arg1, &r.arg2, &r.arg3};
+
+    if (tag == 0) {
+      /* Next stream; interpolate the tail of this one with its last rate. */
+      char magic[TRACE_STREAM_MAGIC_SIZE - 1];
+      if (fread(magic, 1, sizeof magic, f) != sizeof magic
+          || memcmp(magic, TRACE_STREAM_MAGIC + 1, sizeof magic) != 0) {
+        fprintf(stderr, "malformed trace stream header\n");
+        exit(1);
       }
+      emitPending(pending, &sync, func);
+      sync.valid = false;
+      sync.rate = 1.0;
+      lastTsc = 0;
+      readStreamHeader(f, &proc);
+      continue;
+    }
 
-    } while (evbatchsize == BUFFER_SIZE);
+    if (!readVarint(f, &delta))
+      break;
+    lastTsc += (delta >> 1) ^ -(delta & 1);
+
+    r.tsc = lastTsc;
+    r.kind = tag >> 3;
+    r.proc = proc;
+    for (int i = 0; i < 3; i++) {
+      uint64_t arg = 0;
+      if ((tag & (1 << i)) && !readVarint(f, &arg))
+        break;
+      *args[i] = arg;
+    }
+
+    if (r.kind == EVENT_TRACE_CLOCK)
+      syncClock(pending, &sync, r.tsc, r.arg1, func);
+    else
+      pushPending(pending, &r);
+  }
+
+  emitPending(pending, &sync, func);
+}
+
+static int compareRecordTsc(const void *a, const void *b) {
+  const struct TraceRecord *ra = a, *rb = b;
+  return (ra->tsc > rb->tsc) - (ra->tsc < rb->tsc);
+}
+
+/* Ring buffers dumped by `mltrace corelog` hold raw records, without clock
+ * synchronization; their timestamps are reported as is. Slots that were
+ * never written have kind 0. The first prefixSize bytes of the dump have
+ * already been read into prefix. */
+static void decodeRawRings(FILE *f, const unsigned char *prefix,
+                           size_t prefixSize,
+                           struct PendingEvents *pending,
+                           void (*func)(struct Event *)) {
+  struct TraceRecord r;
+  unsigned char *bytes = (unsigned char *)&r;
+  size_t have = prefixSize;
+
+  memcpy(bytes, prefix, prefixSize);
+  while (fread(bytes + have, 1, sizeof r - have, f) == sizeof r - have) {
+    if (r.kind != EVENT_NIL)
+      pushPending(pending, &r);
+    have = 0;
+  }
+
+  qsort(pending->records, pending->count, sizeof *pending->records,
+        compareRecordTsc);
+  for (size_t i = 0; i < pending->count; i++)
+    emitRecord(&pending->records[i], pending->records[i].tsc, func);
+  pending->count = 0;
+}
+
+void processFiles(size_t filecount, FILE **files,
+                  void (*func)(struct Event *)) {
+  struct PendingEvents pending = {NULL, 0, 0};
+
+  /* A raw record is larger than the magic, so a raw dump that doesn't
+   * start with the whole magic loses nothing by having it read. */
+  assert(sizeof(struct TraceRecord) >= TRACE_STREAM_MAGIC_SIZE);
+
+  for (size_t i = 0; i < filecount; ++i) {
+    unsigned char head[TRACE_STREAM_MAGIC_SIZE];
+    size_t n = fread(head, 1, sizeof head, files[i]);
+
+    if (n == 0)
+      continue;
+    else if (n == sizeof head
+             && memcmp(head, TRACE_STREAM_MAGIC, sizeof head) == 0)
+      decodeStreams(files[i], &pending, func);
+    else
+      decodeRawRings(files[i], head, n, &pending, func);
   }
 
+  free(pending.records);
+}
+
+static bool chromeTracingFirst;
+
+static void printEventChromeTracingJSONSeparated(struct Event *event) {
+  if (chromeTracingFirst) chromeTracingFirst = false;
+  else printf(",\n");
+
+  printf("  ");
+  printEventChromeTracingJSON(event);
+}
+
+void processFilesChromeTracingJSON(size_t filecount, FILE **files)
+{
+  printf("[\n");
+
+  chromeTracingFirst = true;
+  processFiles(filecount, files, printEventChromeTracingJSONSeparated);
+
   printf("]\n");
 }
 
@@ -414,6 +614,10 @@ void printEventText(struct Event *event) {
            event->arg1, event->arg2, event->arg3);
     break;
 
+  case EVENT_TRACE_DROPPED:
+    printf("events = %lld", event->arg1);
+    break;
+
   default:
     printf("?1 = %llx, ?2 = %llx, ?3 = %llx",
            event->arg1, event->arg2, event->arg3);
@@ -91,6 +91,7 @@ extern C_Pthread_Key_t gcstate_key;
 #include "gc/objptr.c"
 #include "gc/pack.c"
 #include "gc/parallel.c"
+#include "gc/perf-counters.c"
 #include "gc/pin.c"
 #include "gc/pointer.c"
 #include "gc/profiling.c"
@@ -103,12 +104,15 @@ extern C_Pthread_Key_t gcstate_key;
 #include "gc/share.c"
 #include "gc/signals.c"
 #include "gc/size.c"
+#include "gc/size-class-allocator.c"
 #include "gc/sources.c"
 #include "gc/stack.c"
 #include "gc/static-heaps.c"
 #include "gc/statistics.c"
+#include "gc/statistics-export.c"
 #include "gc/switch-thread.c"
 #include "gc/thread.c"
 #include "gc/weak.c"
+#include "gc/work-team.c"
 #include "gc/world.c"
 #include "gc/decheck.c"
@@ -46,6 +46,7 @@ typedef GC_state GCState_t;
 #include "gc/stack.h"
 #include "gc/chunk.h"
 #include "gc/fixed-size-allocator.h"
+#include "gc/size-class-allocator.h"
 #include "gc/thread.h"
 #include "gc/weak.h"
 #include "gc/int-inf.h"
@@ -55,8 +56,10 @@ typedef GC_state GCState_t;
 #include "gc/current.h"
 #include "gc/sysvals.h"
 #include "gc/controls.h"
+#include "gc/perf-counters.h"
 #include "gc/major.h"
 #include "gc/statistics.h"
+#include "gc/statistics-export.h"
 #include "gc/forward.h"
 #include "gc/invariant.h"
 #include "gc/atomic.h"
@@ -141,6 +141,15 @@ void Assignable_writeBarrier(
 
   HM_HierarchicalHeap dstHH = HM_getLevelHead(HM_getChunkOf(dstp));
 
+  /* Let generated code skip this call for stores that stay within the
+   * current leaf heap; see writeBarrierLevelHead in gc_state.h. */
+  if (dstHH == getThreadCurrent(s)->hierarchicalHeap
+      && HM_getChunkOf(dstp)->levelHead == HM_HH_getUFNode(dstHH)
+      && HM_HH_getConcurrentPack(dstHH)->ccstate == CC_UNREG)
+  {
+    s->writeBarrierLevelHead = HM_HH_getUFNode(dstHH);
+  }
+
   objptr readVal = *field;
   if (dstHH->depth >= 1 && isObjptr(readVal) && s->wsQueueTop!=BOGUS_OBJPTR) {
     pointer currp = objptrToPointer(readVal, NULL);
@@ -198,7 +207,7 @@ void Assignable_writeBarrier(
         assert(NULL != shh);
         assert(HM_HH_getConcurrentPack(shh)->ccstate == CC_UNREG);
 
-        HM_HH_rememberAtLevel(shh, remElem, false);
+        HM_HH_rememberBuffered(s, shh, remElem);
         LOG(LM_HH_PROMOTION, LL_INFO,
             "remembered downptr %" PRIu32 "->%" PRIu32 " from " FMTOBJPTR " to " FMTOBJPTR,
             dstHH->depth, srcHH->depth,
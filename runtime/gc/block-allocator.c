@@ -7,6 +7,7 @@
 #if (defined (MLTON_GC_INTERNAL_FUNCS))
 
 #define INFO_BUFFER_LEN 256
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
 
 static inline size_t SUPERBLOCK_SIZE(GC_state s) {
   return (1 << s->controls->superblockThreshold);
@@ -118,13 +119,8 @@ static void assertBlockAllocatorOkay(GC_state s, BlockAllocator ball) {
 
 
 static void initBlockAllocator(GC_state s, BlockAllocator ball) {
-  size_t numMegaBlockSizeClasses =
-    s->controls->megablockThreshold - s->controls->superblockThreshold;
-
   ball->sizeClassFullnessGroup =
     malloc(s->controls->superblockThreshold * NUM_FULLNESS_GROUPS * sizeof(struct SuperBlockList));
-  ball->megaBlockSizeClass =
-    malloc(numMegaBlockSizeClasses * sizeof(struct MegaBlockList));
 
   for (size_t i = 0; i < s->controls->superblockThreshold; i++) {
     for (int j = 0; j < NUM_FULLNESS_GROUPS; j++) {
@@ -142,20 +138,69 @@ static void initBlockAllocator(GC_state s, BlockAllocator ball) {
     ball->numBlocksFreed[p] = 0;
   }
 
-  for (size_t i = 0; i < numMegaBlockSizeClasses; i++) {
-    ball->megaBlockSizeClass[i].firstMegaBlock = NULL;
+  ball->numNodes = 0;
+  ball->nodeOfProc = NULL;
+  ball->megaBlockPools = NULL;
+
+  ball->numBlocksHeld = 0;
+}
+
+
+/** Figure out which NUMA node each proc runs on, and set up one megablock
+  * pool per node. Procs are only pinned to CPUs when setAffinity is on (see
+  * MLton_threadFunc), so otherwise we treat the machine as a single node.
+  */
+static void initMegaBlockPools(GC_state s, BlockAllocator global) {
+  size_t numMegaBlockSizeClasses =
+    s->controls->megablockThreshold - s->controls->superblockThreshold;
+
+  global->nodeOfProc = malloc(s->numberOfProcs * sizeof(uint32_t));
+  global->numNodes = 1;
+  for (uint32_t p = 0; p < s->numberOfProcs; p++) {
+    uint32_t node = 0;
+    if (s->controls->setAffinity && s->numberOfProcs > 1) {
+      uint32_t cpu =
+        p * s->controls->affinityStride + s->controls->affinityBase;
+      node = GC_numaNodeOfCPU(cpu);
+    }
+    global->nodeOfProc[p] = node;
+    global->numNodes = max(global->numNodes, node+1);
+  }
+
+  global->megaBlockPools =
+    malloc(global->numNodes * sizeof(struct MegaBlockPool));
+  for (uint32_t n = 0; n < global->numNodes; n++) {
+    MegaBlockPool pool = &(global->megaBlockPools[n]);
+    pool->sizeClass =
+      malloc(numMegaBlockSizeClasses * sizeof(struct MegaBlockList));
+    for (size_t i = 0; i < numMegaBlockSizeClasses; i++) {
+      pool->sizeClass[i].firstMegaBlock = NULL;
+    }
+    pthread_mutex_init(&(pool->lock), NULL);
   }
-  pthread_mutex_init(&(ball->megaBlockLock), NULL);
+
+  LOG(LM_BLOCK_ALLOCATOR, LL_INFO,
+    "megablock pools for %u NUMA node(s)",
+    global->numNodes);
 }
 
 
 BlockAllocator initGlobalBlockAllocator(GC_state s) {
   s->blockAllocatorGlobal = malloc(sizeof(struct BlockAllocator));
   initBlockAllocator(s, s->blockAllocatorGlobal);
+  initMegaBlockPools(s, s->blockAllocatorGlobal);
   return s->blockAllocatorGlobal;
 }
 
 
+static inline uint32_t myNumaNode(GC_state s) {
+  BlockAllocator global = s->blockAllocatorGlobal;
+  if (s->procNumber < 0 || (uint32_t)s->procNumber >= s->numberOfProcs)
+    return 0;
+  return global->nodeOfProc[s->procNumber];
+}
+
+
 void initLocalBlockAllocator(GC_state s, BlockAllocator globalBall) {
   // s->controls->blockSize;
   s->blockAllocatorGlobal = globalBall;
@@ -215,20 +260,112 @@ static void setSuperBlockSizeClass(GC_state s, SuperBlock sb, int sizeClass) {
 }
 
 
-static void mmapNewSuperBlocks(
+/** Map fresh memory for blocks. With huge-pages, the mapping is aligned to
+  * HUGE_PAGE_SIZE (by over-mapping and trimming) so that the kernel can back
+  * it with transparent huge pages. */
+static pointer mmapBlocks(GC_state s, size_t length) {
+  if (!s->controls->hugePages)
+    return GC_mmapAnon(NULL, length);
+
+  size_t paddedLength = length + HUGE_PAGE_SIZE;
+  pointer start = GC_mmapAnon(NULL, paddedLength);
+  if (MAP_FAILED == start)
+    return start;
+
+  pointer alignedStart = (pointer)align((size_t)start, HUGE_PAGE_SIZE);
+  size_t frontGap = (size_t)(alignedStart - start);
+  size_t backGap = paddedLength - frontGap - length;
+  if (frontGap > 0)
+    GC_release(start, frontGap);
+  if (backGap > 0)
+    GC_release(alignedStart + length, backGap);
+
+  GC_adviseHugePages(alignedStart, length);
+  return alignedStart;
+}
+
+
+/** Account for mapping numBlocks more blocks. If withinHeapLimit, refuse
+  * instead when that would take the heap past max-heap. */
+static bool tryHoldBlocks(GC_state s, size_t numBlocks, bool withinHeapLimit) {
+  BlockAllocator global = s->blockAllocatorGlobal;
+  size_t maxHeap = s->controls->hhConfig.maxHeap;
+
+  if (0 == maxHeap || !withinHeapLimit) {
+    __sync_fetch_and_add(&(global->numBlocksHeld), numBlocks);
+    return TRUE;
+  }
+
+  size_t limit = maxHeap / s->controls->blockSize;
+  size_t held = global->numBlocksHeld;
+  while (TRUE) {
+    if (held + numBlocks > limit)
+      return FALSE;
+    size_t old =
+      __sync_val_compare_and_swap(&(global->numBlocksHeld), held, held + numBlocks);
+    if (old == held)
+      return TRUE;
+    held = old;
+  }
+}
+
+
+static inline void unholdBlocks(GC_state s, size_t numBlocks) {
+  __sync_fetch_and_sub(&(s->blockAllocatorGlobal->numBlocksHeld), numBlocks);
+}
+
+
+bool holdReservedBlocks(GC_state s, size_t numBlocks, bool withinHeapLimit) {
+  if (tryHoldBlocks(s, numBlocks, withinHeapLimit))
+    return TRUE;
+  tryHoldBlocks(s, numBlocks, FALSE);
+  return FALSE;
+}
+
+
+void unholdReservedBlocks(GC_state s, size_t numBlocks) {
+  unholdBlocks(s, numBlocks);
+}
+
+
+static void dieOutOfSpace(GC_state s) {
+  if (s->controls->hhConfig.maxHeap > 0) {
+    DIE("ran out of space! (max-heap %s bytes, %s mapped)",
+        uintmaxToCommaString(s->controls->hhConfig.maxHeap),
+        uintmaxToCommaString(queryCurrentBytesMapped(s)));
+  }
+  DIE("ran out of space!");
+}
+
+
+/** Superblocks are only ever mapped by the local allocator of the proc that
+  * will use them, which also writes the superblock headers. So with the
+  * kernel's default first-touch policy, they land on the node of their owner
+  * (as long as procs are pinned; see setAffinity).
+  */
+static bool mmapNewSuperBlocks(
   GC_state s,
-  BlockAllocator ball)
+  BlockAllocator ball,
+  bool withinHeapLimit)
 {
   size_t oneWidth = s->controls->blockSize * (1 + SUPERBLOCK_SIZE(s));
+  size_t blocksPerWidth = 1 + SUPERBLOCK_SIZE(s);
   size_t count = 1 + (s->controls->allocBlocksMinSize-1) / oneWidth;
   assert(count * oneWidth >= s->controls->allocBlocksMinSize);
-  pointer start = GC_mmapAnon(NULL, count * oneWidth);
+  pointer start = MAP_FAILED;
+  if (tryHoldBlocks(s, count * blocksPerWidth, withinHeapLimit)) {
+    start = mmapBlocks(s, count * oneWidth);
+    if (MAP_FAILED == start)
+      unholdBlocks(s, count * blocksPerWidth);
+  }
   if (MAP_FAILED == start) {
     /** Try again, but the minimum amount of space we actually need. */
     count = 1;
-    start = GC_mmapAnon(NULL, oneWidth);
+    if (!tryHoldBlocks(s, blocksPerWidth, withinHeapLimit))
+      return FALSE;
+    start = mmapBlocks(s, oneWidth);
     if (MAP_FAILED == start)
-      DIE("ran out of space!");
+      dieOutOfSpace(s);
   }
   assert(isAligned((size_t)start, s->controls->blockSize));
 
@@ -244,6 +381,7 @@ static void mmapNewSuperBlocks(
   }
 
   ball->numBlocksMapped += count*(SUPERBLOCK_SIZE(s));
+  return TRUE;
 }
 
 
@@ -369,7 +507,25 @@ static void localFreeBlocks(GC_state s, SuperBlock sb, FreeBlock b) {
   SuperBlockList oldList = getFullnessGroup(s, ball, sb->sizeClass, fg);
   unlinkSuperBlock(oldList, sb);
   deallocateInSuperBlock(s, sb, b, sb->sizeClass);
-  SuperBlockList newList = getFullnessGroup(s, ball, sb->sizeClass, fullness(s, sb));
+  enum FullnessGroup newfg = fullness(s, sb);
+  SuperBlockList newList = getFullnessGroup(s, ball, sb->sizeClass, newfg);
+
+  /** Give the memory of a completely empty superblock back to the OS, except
+    * for the first block (which holds the superblock header). We always keep
+    * one empty superblock warm, to avoid paying for this repeatedly when a
+    * single superblock goes back and forth between empty and non-empty.
+    * Nothing reads the contents of the free blocks of an empty superblock;
+    * its freelist is reset when it is reused (see setSuperBlockSizeClass).
+    */
+  if (newfg == COMPLETELY_EMPTY &&
+      s->controls->releaseEmptyBlocks &&
+      NULL != newList->firstSuperBlock)
+  {
+    GC_decommit(
+      (pointer)sb + s->controls->blockSize,
+      s->controls->blockSize * SUPERBLOCK_SIZE(s));
+  }
+
   prependSuperBlock(newList, sb);
 }
 
@@ -424,15 +580,26 @@ static void freeMegaBlock(GC_state s, MegaBlock mb, size_t sizeClass) {
       
     __sync_fetch_and_add(&(global->numBlocksFreed[purpose]), nb);
     __sync_fetch_and_add(&(global->numBlocksReleased), nb);
+    unholdBlocks(s, nb);
     return;
   }
 
   size_t mbClass = sizeClass - s->controls->superblockThreshold;
 
-  pthread_mutex_lock(&(global->megaBlockLock));
-  mb->nextMegaBlock = global->megaBlockSizeClass[mbClass].firstMegaBlock;
-  global->megaBlockSizeClass[mbClass].firstMegaBlock = mb;
-  pthread_mutex_unlock(&(global->megaBlockLock));
+  /** The first block holds the megablock header, so keep that one. */
+  if (s->controls->releaseEmptyBlocks && nb > 1) {
+    GC_decommit(
+      (pointer)mb + s->controls->blockSize,
+      s->controls->blockSize * (nb - 1));
+  }
+
+  /** Return it to the pool of its home node, regardless of who is freeing. */
+  assert(mb->node < global->numNodes);
+  MegaBlockPool pool = &(global->megaBlockPools[mb->node]);
+  pthread_mutex_lock(&(pool->lock));
+  mb->nextMegaBlock = pool->sizeClass[mbClass].firstMegaBlock;
+  pool->sizeClass[mbClass].firstMegaBlock = mb;
+  pthread_mutex_unlock(&(pool->lock));
 
   __sync_fetch_and_add(&(global->numBlocksFreed[purpose]), nb);
   return;
@@ -441,12 +608,14 @@ static void freeMegaBlock(GC_state s, MegaBlock mb, size_t sizeClass) {
 
 static MegaBlock tryFindMegaBlock(
   GC_state s,
+  uint32_t node,
   size_t numBlocksNeeded,
   size_t sizeClass,
   enum BlockPurpose purpose)
 {
   BlockAllocator global = s->blockAllocatorGlobal;
   assert(sizeClass >= s->controls->superblockThreshold);
+  assert(node < global->numNodes);
 
   if (sizeClass >= s->controls->megablockThreshold)
     return NULL;
@@ -454,14 +623,15 @@ static MegaBlock tryFindMegaBlock(
   size_t numMbSizeClasses =
     s->controls->megablockThreshold - s->controls->superblockThreshold;
 
-  pthread_mutex_lock(&(global->megaBlockLock));
+  MegaBlockPool pool = &(global->megaBlockPools[node]);
+  pthread_mutex_lock(&(pool->lock));
 
   size_t lower = sizeClass - s->controls->superblockThreshold;
   size_t upper = min(lower+2, numMbSizeClasses);
   size_t count = 0;
 
   for (size_t i = lower; i < upper; i++) {
-    for (MegaBlock *mbp = &(global->megaBlockSizeClass[i].firstMegaBlock);
+    for (MegaBlock *mbp = &(pool->sizeClass[i].firstMegaBlock);
          *mbp != NULL;
          mbp = &((*mbp)->nextMegaBlock))
     {
@@ -471,30 +641,39 @@ static MegaBlock tryFindMegaBlock(
       if (mb->numBlocks >= numBlocksNeeded) {
         *mbp = mb->nextMegaBlock;
         mb->nextMegaBlock = NULL;
-        pthread_mutex_unlock(&(global->megaBlockLock));
+        pthread_mutex_unlock(&(pool->lock));
 
         __sync_fetch_and_add(&(global->numBlocksAllocated[purpose]), mb->numBlocks);
 
         LOG(LM_CHUNK_POOL, LL_INFO,
-          "inspected %zu, satisfied large alloc of %zu blocks using megablock of %zu",
+          "inspected %zu, satisfied large alloc of %zu blocks using megablock of %zu (node %u)",
           count,
           numBlocksNeeded,
-          mb->numBlocks);
+          mb->numBlocks,
+          node);
 
         return mb;
       }
     }
   }
 
-  pthread_mutex_unlock(&(global->megaBlockLock));
+  pthread_mutex_unlock(&(pool->lock));
   return NULL;
 }
 
 
-static MegaBlock mmapNewMegaBlock(GC_state s, size_t numBlocks, enum BlockPurpose purpose)
+static MegaBlock mmapNewMegaBlock(
+  GC_state s,
+  size_t numBlocks,
+  enum BlockPurpose purpose,
+  bool withinHeapLimit)
 {
-  pointer start = GC_mmapAnon(NULL, s->controls->blockSize * numBlocks);
+  if (!tryHoldBlocks(s, numBlocks, withinHeapLimit))
+    return NULL;
+
+  pointer start = mmapBlocks(s, s->controls->blockSize * numBlocks);
   if (MAP_FAILED == start) {
+    unholdBlocks(s, numBlocks);
     return NULL;
   }
   if (!isAligned((size_t)start, s->controls->blockSize)) {
@@ -509,6 +688,7 @@ static MegaBlock mmapNewMegaBlock(GC_state s, size_t numBlocks, enum BlockPurpos
   mb->numBlocks = numBlocks;
   mb->nextMegaBlock = NULL;
   mb->purpose = purpose;
+  mb->node = myNumaNode(s);
 
   LOG(LM_CHUNK_POOL, LL_INFO,
     "mmap'ed new megablock of size %zu",
@@ -518,7 +698,12 @@ static MegaBlock mmapNewMegaBlock(GC_state s, size_t numBlocks, enum BlockPurpos
 }
 
 
-Blocks allocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose purpose) {
+static Blocks allocateBlocksWithLimit(
+  GC_state s,
+  size_t numBlocks,
+  enum BlockPurpose purpose,
+  bool withinHeapLimit)
+{
   BlockAllocator local = s->blockAllocatorLocal;
   assertBlockAllocatorOkay(s, local);
 
@@ -526,24 +711,36 @@ Blocks allocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose
 
   if ((size_t)class >= s->controls->superblockThreshold) {
 
-    /** First see if we can reuse. If not, try mmap a new one. If that all
-      * fails, we're a bit screwed.
+    /** First see if we can reuse one from our own node. If not, try mmap a
+      * new one (which will be placed on our node by first-touch). Only then
+      * fall back on the other nodes. If that all fails, we're a bit screwed.
       */
+    BlockAllocator global = s->blockAllocatorGlobal;
+    uint32_t node = myNumaNode(s);
 
-    MegaBlock mb = tryFindMegaBlock(s, numBlocks, class, purpose);
+    MegaBlock mb = tryFindMegaBlock(s, node, numBlocks, class, purpose);
 
     if (NULL == mb)
-      mb = mmapNewMegaBlock(s, numBlocks, purpose);
+      mb = mmapNewMegaBlock(s, numBlocks, purpose, withinHeapLimit);
+
+    for (uint32_t i = 1; NULL == mb && i < global->numNodes; i++) {
+      uint32_t other = (node + i) % global->numNodes;
+      mb = tryFindMegaBlock(s, other, numBlocks, class, purpose);
+    }
 
+    if (NULL == mb && withinHeapLimit)
+      return NULL;
     if (NULL == mb)
-      DIE("ran out of space!");
+      dieOutOfSpace(s);
 
     size_t actualNumBlocks = mb->numBlocks;
+    uint32_t mbNode = mb->node;
     assert(actualNumBlocks >= numBlocks);
     Blocks bs = (Blocks)mb;
     bs->container = NULL;
     bs->numBlocks = actualNumBlocks;
     bs->purpose = purpose;
+    bs->node = mbNode;
     return bs;
   }
 
@@ -559,7 +756,8 @@ Blocks allocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose
   }
 
   /** If both local fails, we need to mmap new superchunks. */
-  mmapNewSuperBlocks(s, local);
+  if (!mmapNewSuperBlocks(s, local, withinHeapLimit))
+    return NULL;
 
   result = tryAllocateAndAdjustSuperBlocks(s, local, class, purpose);
   if (result == NULL) {
@@ -572,6 +770,57 @@ Blocks allocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose
 }
 
 
+Blocks allocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose purpose) {
+  return allocateBlocksWithLimit(s, numBlocks, purpose, FALSE);
+}
+
+
+Blocks tryAllocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose purpose) {
+  return allocateBlocksWithLimit(s, numBlocks, purpose, TRUE);
+}
+
+
+static Blocks allocateFreshBlocksWithLimit(
+  GC_state s,
+  size_t numBlocks,
+  enum BlockPurpose purpose,
+  bool withinHeapLimit)
+{
+  int class = computeSizeClass(numBlocks);
+
+  /** Small requests come out of superblocks, which we don't bypass. */
+  if ((size_t)class < s->controls->superblockThreshold)
+    return allocateBlocksWithLimit(s, numBlocks, purpose, withinHeapLimit);
+
+  MegaBlock mb = mmapNewMegaBlock(s, numBlocks, purpose, withinHeapLimit);
+  if (NULL == mb)
+    return allocateBlocksWithLimit(s, numBlocks, purpose, withinHeapLimit);
+
+  LOG(LM_CHUNK_POOL, LL_INFO,
+    "fresh allocation of %zu blocks",
+    numBlocks);
+
+  size_t actualNumBlocks = mb->numBlocks;
+  uint32_t mbNode = mb->node;
+  Blocks bs = (Blocks)mb;
+  bs->container = NULL;
+  bs->numBlocks = actualNumBlocks;
+  bs->purpose = purpose;
+  bs->node = mbNode;
+  return bs;
+}
+
+
+Blocks allocateFreshBlocks(GC_state s, size_t numBlocks, enum BlockPurpose purpose) {
+  return allocateFreshBlocksWithLimit(s, numBlocks, purpose, FALSE);
+}
+
+
+Blocks tryAllocateFreshBlocks(GC_state s, size_t numBlocks, enum BlockPurpose purpose) {
+  return allocateFreshBlocksWithLimit(s, numBlocks, purpose, TRUE);
+}
+
+
 Blocks allocateBlocks(GC_state s, size_t numBlocks) {
   return allocateBlocksWithPurpose(s, numBlocks, BLOCK_FOR_UNKNOWN_PURPOSE);
 }
@@ -584,6 +833,7 @@ void freeBlocks(GC_state s, Blocks bs, writeFreedBlockInfoFnClosure f) {
   size_t numBlocks = bs->numBlocks;
   SuperBlock sb = bs->container;
   enum BlockPurpose purpose = bs->purpose;
+  uint32_t node = bs->node;
   pointer blockStart = (pointer)bs;
 
 #if ASSERT
@@ -629,6 +879,7 @@ void freeBlocks(GC_state s, Blocks bs, writeFreedBlockInfoFnClosure f) {
     mb->numBlocks = numBlocks;
     mb->nextMegaBlock = NULL;
     mb->purpose = purpose;
+    mb->node = node;
     freeMegaBlock(s, mb, sizeClass);
     return;
   }
@@ -648,7 +899,8 @@ void freeBlocks(GC_state s, Blocks bs, writeFreedBlockInfoFnClosure f) {
     return;
   }
 
-  /** Otherwise, enqueue for the other proc to handle. */
+  /** Otherwise, enqueue for the other proc to handle. This also keeps blocks
+    * on the node of the proc that first touched them. */
   while (TRUE) {
     FreeBlock oldVal = owner->firstFreedByOther;
     elem->nextFree = oldVal;
@@ -701,6 +953,26 @@ void queryCurrentBlockUsage(
 }
 
 
+size_t queryCurrentBytesMapped(GC_state s) {
+  return s->blockAllocatorGlobal->numBlocksHeld * s->controls->blockSize;
+}
+
+
+Word32 GC_heapLimitHit = 0;
+
+
+void setHeapLimitExceeded(__attribute__((unused)) GC_state s) {
+  __atomic_store_n(&GC_heapLimitHit, 1, __ATOMIC_RELAXED);
+}
+
+
+Bool_t GC_heapLimitExceeded(__attribute__((unused)) GC_state s) {
+  if (0 == __atomic_load_n(&GC_heapLimitHit, __ATOMIC_RELAXED))
+    return FALSE;
+  return __sync_bool_compare_and_swap(&GC_heapLimitHit, 1, 0);
+}
+
+
 void logCurrentBlockUsage(
   GC_state s, 
   struct timespec *now, 
@@ -750,6 +1022,7 @@ void logCurrentBlockUsage(
     "  BLOCK_FOR_GC_WORKLIST      %zu (%zu%%) (= %zu - %zu)\n"
     "  BLOCK_FOR_SUSPECTS         %zu (%zu%%) (= %zu - %zu)\n"
     "  BLOCK_FOR_EBR              %zu (%zu%%) (= %zu - %zu)\n"
+    "  BLOCK_FOR_METADATA         %zu (%zu%%) (= %zu - %zu)\n"
     "  BLOCK_FOR_UNKNOWN_PURPOSE  %zu (%zu%%) (= %zu - %zu)\n",
     now->tv_sec,
     now->tv_nsec,
@@ -801,6 +1074,11 @@ void logCurrentBlockUsage(
     allocated[BLOCK_FOR_EBR],
     freed[BLOCK_FOR_EBR],
 
+    inUse[BLOCK_FOR_METADATA],
+    (size_t)(100.0 * (double)inUse[BLOCK_FOR_METADATA] / (double)count),
+    allocated[BLOCK_FOR_METADATA],
+    freed[BLOCK_FOR_METADATA],
+
     inUse[BLOCK_FOR_UNKNOWN_PURPOSE],
     (size_t)(100.0 * (double)inUse[BLOCK_FOR_UNKNOWN_PURPOSE] / (double)count),
     allocated[BLOCK_FOR_UNKNOWN_PURPOSE],
@@ -25,6 +25,7 @@ enum BlockPurpose {
   BLOCK_FOR_GC_WORKLIST,
   BLOCK_FOR_SUSPECTS,
   BLOCK_FOR_EBR,
+  BLOCK_FOR_METADATA,
   BLOCK_FOR_UNKNOWN_PURPOSE,
   NUM_BLOCK_PURPOSES /** Hack to know statically how many there are. Make sure
                        * this comes last in the list. */
@@ -119,6 +120,8 @@ typedef struct MegaBlock {
   struct MegaBlock *nextMegaBlock;
   size_t numBlocks;
   enum BlockPurpose purpose;
+  /** NUMA node of the proc that mapped (and first touched) this megablock. */
+  uint32_t node;
 } *MegaBlock;
 
 
@@ -127,6 +130,13 @@ typedef struct MegaBlockList {
 } *MegaBlockList;
 
 
+/** Free megablocks, one pool per NUMA node. */
+typedef struct MegaBlockPool {
+  struct MegaBlockList *sizeClass;
+  pthread_mutex_t lock;
+} *MegaBlockPool;
+
+
 /** num groups is one less, because we handle COMPLETELY_EMPTY specially. */
 #define NUM_FULLNESS_GROUPS 4
 enum FullnessGroup {
@@ -164,10 +174,20 @@ typedef struct BlockAllocator {
     */
   FreeBlock firstFreedByOther;
 
-  /** Only used in the global allocator (always NULL in the local allocators).
+  /** Only used in the global allocator (always 0/NULL in the local
+    * allocators). Megablocks are returned to the pool of the node where they
+    * were first touched, and each proc looks in the pool of its own node
+    * first. The node of each proc is determined by the affinity controls;
+    * without affinity, everything is on node 0.
+    */
+  uint32_t numNodes;
+  uint32_t *nodeOfProc;
+  struct MegaBlockPool *megaBlockPools;
+
+  /** Also only used in the global allocator. The number of blocks currently
+    * mapped by all allocators (mapped minus released), which max-heap bounds.
     */
-  struct MegaBlockList *megaBlockSizeClass;
-  pthread_mutex_t megaBlockLock;
+  size_t numBlocksHeld;
 
 } *BlockAllocator;
 
@@ -176,6 +196,9 @@ typedef struct Blocks {
   SuperBlock container;
   size_t numBlocks;
   enum BlockPurpose purpose;
+  /** Only meaningful for megablocks (container == NULL). Superblocks always
+    * go back to their owner, see freeBlocks. */
+  uint32_t node;
 } *Blocks;
 
 #else
@@ -197,6 +220,26 @@ Blocks allocateBlocks(GC_state s, size_t numBlocks);
 
 Blocks allocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose purpose);
 
+/** Like allocateBlocksWithPurpose, but large requests skip the megablock
+  * pools and always get a new mapping. Apart from the first block, whose
+  * header we write, the pages are zero and untouched, so they will be placed
+  * by whoever first writes them. */
+Blocks allocateFreshBlocks(GC_state s, size_t numBlocks, enum BlockPurpose purpose);
+
+/** The above never refuse because of max-heap: the runtime's own allocations
+  * (e.g. to-space during a collection) may go past it. These variants are for
+  * growing the heap on behalf of the mutator, and return NULL instead of
+  * going past max-heap. */
+Blocks tryAllocateBlocksWithPurpose(GC_state s, size_t numBlocks, enum BlockPurpose purpose);
+Blocks tryAllocateFreshBlocks(GC_state s, size_t numBlocks, enum BlockPurpose purpose);
+
+/** The reserved tail of a stack chunk (see HM_reserveChunkTail) does not
+  * count as held against max-heap until the stack grows into it. These move
+  * such blocks into and out of the count. Holding never refuses; it returns
+  * FALSE if withinHeapLimit and the heap is now past max-heap. */
+bool holdReservedBlocks(GC_state s, size_t numBlocks, bool withinHeapLimit);
+void unholdReservedBlocks(GC_state s, size_t numBlocks);
+
 /** Free a group of contiguous blocks. */
 void freeBlocks(GC_state s, Blocks bs, writeFreedBlockInfoFnClosure f);
 
@@ -219,6 +262,24 @@ void queryCurrentBlockUsage(
 
 Sampler newBlockUsageSampler(GC_state s);
 
+/** Bytes currently mapped for blocks, over all processors. Unlike
+  * queryCurrentBlockUsage, this is a single read. */
+size_t queryCurrentBytesMapped(GC_state s);
+
+void setHeapLimitExceeded(GC_state s);
+
 #endif
 
+#if (defined (MLTON_GC_INTERNAL_BASIS))
+
+/** Nonzero when the heap has been found full (even after collecting) since
+  * the mutator last called GC_heapLimitExceeded. A plain global, so that the
+  * mutator can poll it cheaply at every allocation. */
+PRIVATE extern Word32 GC_heapLimitHit;
+
+/** Whether the heap has hit max-heap since the last call. */
+PRIVATE Bool_t GC_heapLimitExceeded(GC_state s);
+
+#endif /* (defined (MLTON_GC_INTERNAL_BASIS)) */
+
 #endif // BLOCK_ALLOCATOR_H_
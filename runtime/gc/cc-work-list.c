@@ -2,6 +2,13 @@
 
 #if (defined (MLTON_GC_INTERNAL_FUNCS))
 
+/* Sequence ranges with at least this many cells left are split in half
+ * when shared, rather than handed over whole. */
+#define CC_WORKLIST_SPLIT_CELLS 4096
+
+/* While tracing a sequence, prefetch the objects referenced by the cell
+ * this many cells ahead. */
+#define CC_WORKLIST_PREFETCH_CELLS 8
 
 void CC_workList_init(
   __attribute__((unused)) GC_state s,
@@ -89,6 +96,7 @@ bool makeInitialElem(GC_state s, objptr op, CC_workList_elem result) {
 
     result->op = op;
     result->data.sequence.cellIdx = 0;
+    result->data.sequence.cellEnd = getSequenceLength(objptrToPointer(op, NULL));
     result->data.sequence.objptrIdx = 0;
     return TRUE;
   }
@@ -122,15 +130,11 @@ bool makeInitialElem(GC_state s, objptr op, CC_workList_elem result) {
 }
 
 
-void CC_workList_push(
-  GC_state s,
+static void pushElem(
+  __attribute__((unused)) GC_state s,
   CC_workList w,
-  objptr op)
+  CC_workList_elem elem)
 {
-  struct CC_workList_elem elem;
-  if (!makeInitialElem(s, op, &elem))
-    return;
-
   HM_chunkList list = &(w->storage);
   HM_chunk chunk = w->currentChunk;
   size_t elemSize = sizeof(struct CC_workList_elem);
@@ -158,11 +162,141 @@ void CC_workList_push(
     chunk,
     frontier + elemSize);
 
-  *(CC_workList_elem)frontier = elem;
+  *(CC_workList_elem)frontier = *elem;
   return;
 }
 
 
+void CC_workList_push(
+  GC_state s,
+  CC_workList w,
+  objptr op)
+{
+  struct CC_workList_elem elem;
+  if (!makeInitialElem(s, op, &elem))
+    return;
+
+  pushElem(s, w, &elem);
+}
+
+
+/** Returns the topmost element of the work list (NULL if empty), but
+  * doesn't remove it.
+  */
+static CC_workList_elem topElem(GC_state s, CC_workList w) {
+  HM_chunkList list = &(w->storage);
+  HM_chunk chunk = w->currentChunk;
+
+  if (HM_getChunkFrontier(chunk) <= HM_getChunkStart(chunk)) {
+    // chunk is empty; try to move backwards
+
+    HM_chunk prevChunk = chunk->prevChunk;
+    if (prevChunk == NULL) {
+      // whole worklist is empty
+      return NULL;
+    }
+
+    /** Otherwise, there is a chunk before us. It's now safe (for cost
+      * amortization) to delete the chunk after us, if there is one.
+      */
+    if (NULL != chunk->nextChunk) {
+      HM_chunk nextChunk = chunk->nextChunk;
+      HM_unlinkChunk(list, nextChunk);
+      HM_freeChunkWithInfo(s, nextChunk, NULL, BLOCK_FOR_GC_WORKLIST);
+    }
+
+    assert(NULL == chunk->nextChunk);
+    assert(prevChunk == chunk->prevChunk);
+
+    chunk = prevChunk;
+    w->currentChunk = chunk;
+  }
+
+  assert(w->currentChunk == chunk);
+  assert(HM_getChunkFrontier(chunk) >= HM_getChunkStart(chunk) + sizeof(struct CC_workList_elem));
+
+  pointer frontier = HM_getChunkFrontier(chunk);
+  return (CC_workList_elem)(frontier - sizeof(struct CC_workList_elem));
+}
+
+
+size_t CC_workList_moveElems(
+  GC_state s,
+  CC_workList from,
+  CC_workList to,
+  size_t count)
+{
+  size_t moved = 0;
+  while (moved < count) {
+    CC_workList_elem elem = topElem(s, from);
+    if (NULL == elem)
+      break;
+
+    pushElem(s, to, elem);
+    HM_updateChunkFrontierInList(
+      &(from->storage),
+      from->currentChunk,
+      (pointer)elem);
+    moved++;
+  }
+  return moved;
+}
+
+
+/** If elem is a sequence range that is worth splitting, shrinks it to its
+  * lower half and stores the upper half in upper.
+  */
+static bool trySplitElem(
+  GC_state s,
+  CC_workList_elem elem,
+  CC_workList_elem upper)
+{
+  GC_header header = getHeader(objptrToPointer(elem->op, NULL));
+  GC_objectTypeTag tag;
+  splitHeader(s, header, &tag, NULL, NULL, NULL);
+  if (SEQUENCE_TAG != tag)
+    return FALSE;
+
+  /* The current cell may be partially traced; only whole cells after it
+   * are split off. */
+  size_t lo = elem->data.sequence.cellIdx + 1;
+  size_t hi = elem->data.sequence.cellEnd;
+  if (lo >= hi || hi - lo < CC_WORKLIST_SPLIT_CELLS)
+    return FALSE;
+
+  size_t mid = lo + (hi - lo) / 2;
+  upper->op = elem->op;
+  upper->data.sequence.cellIdx = mid;
+  upper->data.sequence.cellEnd = hi;
+  upper->data.sequence.objptrIdx = 0;
+  elem->data.sequence.cellEnd = mid;
+  return TRUE;
+}
+
+
+size_t CC_workList_shareElems(
+  GC_state s,
+  CC_workList from,
+  CC_workList to,
+  size_t count)
+{
+  if (0 == count)
+    return 0;
+
+  CC_workList_elem elem = topElem(s, from);
+  if (NULL == elem)
+    return 0;
+
+  struct CC_workList_elem upper;
+  if (trySplitElem(s, elem, &upper)) {
+    pushElem(s, to, &upper);
+    return 1;
+  }
+
+  return CC_workList_moveElems(s, from, to, count);
+}
+
+
 struct advanceOneFieldResult {
   objptr* field;
   bool objectDone;
@@ -197,14 +331,29 @@ void advanceOneField(
   // ======================== SEQUENCE OBJECTS ========================
 
   if (SEQUENCE_TAG == tag) {
-    GC_sequenceLength numCells = getSequenceLength(p);
     size_t bytesPerCell = bytesNonObjptrs + (numObjptrs * OBJPTR_SIZE);
 
     size_t cellIdx = elem->data.sequence.cellIdx;
+    size_t cellEnd = elem->data.sequence.cellEnd;
     uint16_t objptrIdx = elem->data.sequence.objptrIdx;
-    assert(cellIdx < numCells);
+    assert(cellIdx < cellEnd);
+    assert(cellEnd <= getSequenceLength(p));
     assert(objptrIdx < numObjptrs);
 
+    /* The cells themselves are read sequentially, which the hardware
+     * prefetches well; what misses is the objects they point to. */
+    if (0 == objptrIdx && cellIdx + CC_WORKLIST_PREFETCH_CELLS < cellEnd) {
+      pointer ahead =
+        p
+        + ((cellIdx + CC_WORKLIST_PREFETCH_CELLS) * bytesPerCell)
+        + bytesNonObjptrs;
+      for (uint16_t i = 0; i < numObjptrs; i++) {
+        objptr op = ((objptr*)ahead)[i];
+        if (isObjptr(op))
+          __builtin_prefetch(objptrToPointer(op, NULL) - GC_HEADER_SIZE);
+      }
+    }
+
     result->field =
       (objptr*)(
         p                            // object start
@@ -219,7 +368,7 @@ void advanceOneField(
     if (objptrIdx+1 == numObjptrs) {
       elem->data.sequence.cellIdx++;
       elem->data.sequence.objptrIdx = 0;
-      if (cellIdx+1 == numCells)
+      if (cellIdx+1 == cellEnd)
         result->objectDone = TRUE;
     }
     return;
@@ -286,49 +435,19 @@ objptr* CC_workList_pop(
   GC_state s,
   CC_workList w)
 {
-  HM_chunkList list = &(w->storage);
-  HM_chunk chunk = w->currentChunk;
-
-  if (HM_getChunkFrontier(chunk) <= HM_getChunkStart(chunk)) {
-    // chunk is empty; try to move backwards
-
-    HM_chunk prevChunk = chunk->prevChunk;
-    if (prevChunk == NULL) {
-      // whole worklist is empty
-      return NULL;
-    }
-
-    /** Otherwise, there is a chunk before us. It's now safe (for cost
-      * amortization) to delete the chunk after us, if there is one.
-      */
-    if (NULL != chunk->nextChunk) {
-      HM_chunk nextChunk = chunk->nextChunk;
-      HM_unlinkChunk(list, nextChunk);
-      HM_freeChunkWithInfo(s, nextChunk, NULL, BLOCK_FOR_GC_WORKLIST);
-    }
-
-    assert(NULL == chunk->nextChunk);
-    assert(prevChunk == chunk->prevChunk);
-
-    chunk = prevChunk;
-    w->currentChunk = chunk;
+  CC_workList_elem elem = topElem(s, w);
+  if (NULL == elem) {
+    return NULL;
   }
 
-  assert(w->currentChunk == chunk);
-  assert(HM_getChunkFrontier(chunk) >= HM_getChunkStart(chunk) + sizeof(struct CC_workList_elem));
-
-  pointer frontier = HM_getChunkFrontier(chunk);
-  pointer elemPtr = frontier - sizeof(struct CC_workList_elem);
-  CC_workList_elem elem = (CC_workList_elem)elemPtr;
-
   struct advanceOneFieldResult r;
   advanceOneField(s, elem, &r);
 
   if (r.objectDone) {
-    pointer newFrontier = elemPtr;
+    pointer newFrontier = (pointer)elem;
     HM_updateChunkFrontierInList(
-      list,
-      chunk,
+      &(w->storage),
+      w->currentChunk,
       newFrontier);
   }
 
@@ -14,8 +14,11 @@ typedef struct CC_workList_elem {
     struct normal {
       uint16_t objptrIdx;
     } normal;
+    /* The cells [cellIdx, cellEnd) of a sequence. A large range can be
+     * split, so that several collector threads trace one sequence. */
     struct sequence {
       size_t cellIdx;
+      size_t cellEnd;
       uint16_t objptrIdx;
     } sequence;
     struct stack {
@@ -51,6 +54,27 @@ void CC_workList_push(GC_state s, CC_workList w, objptr op);
   * Returns NULL if work list is empty */
 objptr* CC_workList_pop(GC_state s, CC_workList w);
 
+/** Move up to `count` whole elements (which may be partially traced) from
+  * the top of one work list to the other. Returns the number moved.
+  */
+size_t CC_workList_moveElems(
+  GC_state s,
+  CC_workList from,
+  CC_workList to,
+  size_t count);
+
+/** Like CC_workList_moveElems, but meant for handing work to idle collector
+  * threads. If the top element is a sequence range of at least
+  * CC_WORKLIST_SPLIT_CELLS cells, it is split instead: the upper half goes
+  * to `to` and the lower half stays. Returns the number of elements added
+  * to `to`.
+  */
+size_t CC_workList_shareElems(
+  GC_state s,
+  CC_workList from,
+  CC_workList to,
+  size_t count);
+
 void CC_workList_free(GC_state s, CC_workList w);
 
 #endif /* MLTON_GC_INTERNAL_FUNCS */
@@ -105,6 +105,8 @@ HM_chunk HM_initializeChunk(pointer start, pointer end) {
   chunk->startGap = 0;
   chunk->pinnedDuringCollection = FALSE;
   chunk->mightContainMultipleObjects = TRUE;
+  chunk->noObjptrs = FALSE;
+  chunk->reservedLimit = NULL;
   chunk->tmpHeap = NULL;
   chunk->decheckState = DECHECK_BOGUS_TID;
   chunk->retireChunk = FALSE;
@@ -119,21 +121,42 @@ HM_chunk HM_initializeChunk(pointer start, pointer end) {
 }
 
 
-HM_chunk HM_getFreeChunkWithPurpose(GC_state s, size_t bytesRequested, enum BlockPurpose purpose) {
+static HM_chunk getFreeChunk(
+  GC_state s,
+  size_t bytesRequested,
+  enum BlockPurpose purpose,
+  bool fresh,
+  bool withinHeapLimit)
+{
   size_t chunkWidth =
     align(bytesRequested + sizeof(struct HM_chunk), HM_BLOCK_SIZE);
   size_t numBlocks = chunkWidth / HM_BLOCK_SIZE;
-  Blocks start = allocateBlocksWithPurpose(s, numBlocks, purpose);
+  Blocks start;
+  if (withinHeapLimit)
+    start = fresh ? tryAllocateFreshBlocks(s, numBlocks, purpose)
+                  : tryAllocateBlocksWithPurpose(s, numBlocks, purpose);
+  else
+    start = fresh ? allocateFreshBlocks(s, numBlocks, purpose)
+                  : allocateBlocksWithPurpose(s, numBlocks, purpose);
+  if (NULL == start)
+    return NULL;
   SuperBlock container = start->container;
   numBlocks = start->numBlocks;
+  uint32_t numaNode = start->node;
   HM_chunk result =
     HM_initializeChunk((pointer)start, (pointer)start + chunkWidth);
   result->container = container;
   result->numBlocks = numBlocks;
+  result->numaNode = numaNode;
   return result;
 }
 
 
+HM_chunk HM_getFreeChunkWithPurpose(GC_state s, size_t bytesRequested, enum BlockPurpose purpose) {
+  return getFreeChunk(s, bytesRequested, purpose, FALSE, FALSE);
+}
+
+
 HM_chunk HM_getFreeChunk(GC_state s, size_t bytesRequested) {
   return HM_getFreeChunkWithPurpose(s, bytesRequested, BLOCK_FOR_UNKNOWN_PURPOSE);
 }
@@ -159,8 +182,9 @@ void writeChunkInfo(
 
   int numCharsWritten =
     snprintf(infoBuffer, bufferLen,
-      "[multiobject %s; gap %u; used %zu] ",
+      "[multiobject %s; objptrs %s; gap %u; used %zu] ",
       (args->descriptor.mightContainMultipleObjects? "yes" : "no"),
+      (args->descriptor.noObjptrs? "no" : "maybe"),
       args->descriptor.startGap,
       (size_t)(args->descriptor.frontier - chunkStart));
 
@@ -200,12 +224,23 @@ void HM_freeChunkWithInfo(
   // ensure the sanity check is disrupted, for debugging
   chunk->magic = 0xfacefade;
 
+  /* The block allocator gives back all of the chunk's blocks, including
+   * those of its reserve, so count them as held again first. */
+  if (NULL != chunk->reservedLimit) {
+    holdReservedBlocks(
+      s,
+      (size_t)(chunk->reservedLimit - chunk->limit) / HM_BLOCK_SIZE,
+      FALSE);
+  }
+
   size_t numBlocks = chunk->numBlocks;
   SuperBlock container = chunk->container;
+  uint32_t numaNode = chunk->numaNode;
   Blocks bs = (Blocks)chunk;
   bs->numBlocks = numBlocks;
   bs->container = container;
   bs->purpose = purpose;
+  bs->node = numaNode;
   freeBlocks(s, bs, &c);
 }
 
@@ -232,13 +267,19 @@ void HM_freeChunksInList(GC_state s, HM_chunkList list) {
   HM_freeChunksInListWithInfo(s, list, NULL, BLOCK_FOR_UNKNOWN_PURPOSE);
 }
 
-HM_chunk HM_allocateChunkWithPurpose(
+static HM_chunk allocateChunk(
   HM_chunkList list,
   size_t bytesRequested,
-  enum BlockPurpose purpose)
+  enum BlockPurpose purpose,
+  bool fresh,
+  bool withinHeapLimit)
 {
   GC_state s = pthread_getspecific(gcstate_key);
-  HM_chunk chunk = HM_getFreeChunkWithPurpose(s, bytesRequested, purpose);
+  HM_chunk chunk =
+    getFreeChunk(s, bytesRequested, purpose, fresh, withinHeapLimit);
+
+  if (NULL == chunk && withinHeapLimit)
+    return NULL;
 
   if (NULL == chunk) {
     DIE("Out of memory. Unable to allocate chunk of size %zu.",
@@ -257,12 +298,76 @@ HM_chunk HM_allocateChunkWithPurpose(
   return chunk;
 }
 
+HM_chunk HM_allocateChunkWithPurpose(
+  HM_chunkList list,
+  size_t bytesRequested,
+  enum BlockPurpose purpose)
+{
+  return allocateChunk(list, bytesRequested, purpose, FALSE, FALSE);
+}
+
+HM_chunk HM_allocateFreshChunk(HM_chunkList list, size_t bytesRequested) {
+  return allocateChunk(list, bytesRequested, BLOCK_FOR_HEAP_CHUNK, TRUE, FALSE);
+}
+
+HM_chunk HM_tryAllocateHeapChunk(
+  HM_chunkList list,
+  size_t bytesRequested,
+  bool fresh)
+{
+  return allocateChunk(list, bytesRequested, BLOCK_FOR_HEAP_CHUNK, fresh, TRUE);
+}
+
 
 HM_chunk HM_allocateChunk(HM_chunkList list, size_t bytesRequested) {
   return HM_allocateChunkWithPurpose(list, bytesRequested, BLOCK_FOR_UNKNOWN_PURPOSE);
 }
 
 
+void HM_reserveChunkTail(
+  GC_state s,
+  HM_chunkList list,
+  HM_chunk chunk,
+  size_t bytes)
+{
+  assert(NULL == chunk->reservedLimit);
+  pointer limit =
+    (pointer)align((size_t)(HM_getChunkStart(chunk) + bytes), HM_BLOCK_SIZE);
+  assert(HM_getChunkFrontier(chunk) <= limit);
+  if (limit >= chunk->limit)
+    return;
+
+  size_t tail = (size_t)(chunk->limit - limit);
+  chunk->reservedLimit = chunk->limit;
+  chunk->limit = limit;
+  list->size -= tail;
+  unholdReservedBlocks(s, tail / HM_BLOCK_SIZE);
+}
+
+bool HM_growReservedChunk(
+  GC_state s,
+  HM_chunkList list,
+  HM_chunk chunk,
+  size_t bytes)
+{
+  if (NULL == chunk->reservedLimit)
+    return FALSE;
+
+  pointer limit =
+    (pointer)align((size_t)(HM_getChunkStart(chunk) + bytes), HM_BLOCK_SIZE);
+  if (limit > chunk->reservedLimit)
+    return FALSE;
+  if (limit <= chunk->limit)
+    return TRUE;
+
+  size_t more = (size_t)(limit - chunk->limit);
+  chunk->limit = limit;
+  list->size += more;
+  if (!holdReservedBlocks(s, more / HM_BLOCK_SIZE, TRUE))
+    setHeapLimitExceeded(s);
+  return TRUE;
+}
+
 void HM_initChunkList(HM_chunkList list) {
   list->firstChunk = NULL;
   list->lastChunk = NULL;
@@ -340,6 +445,10 @@ void HM_forwardHHObjptrsInChunkList(
 
   while (NULL != chunk) {
 
+    /* Nothing to forward in here; skip the object walk entirely. */
+    if (chunk->noObjptrs)
+      p = chunk->frontier;
+
     /* Can I use foreachObjptrInRange() for this? */
     while (p != chunk->frontier) {
       assert(p < chunk->frontier);
@@ -72,6 +72,17 @@ struct HM_chunk {
   bool retireChunk;
 
   bool mightContainMultipleObjects;
+
+  /* set at allocation time for a single-object chunk holding a sequence
+   * whose elements contain no objptrs (e.g. a large Word8 or Real64 array).
+   * Collections move such chunks without scanning them. */
+  bool noObjptrs;
+
+  /* for a stack chunk with a reserved tail (see HM_reserveChunkTail), the end
+   * of its mapping, past limit; NULL for every other chunk. Only the blocks
+   * up to limit count towards list sizes and max-heap. */
+  pointer reservedLimit;
+
   void* tmpHeap;
 
   SuperBlock container;
@@ -79,7 +90,10 @@ struct HM_chunk {
 
   decheck_tid_t decheckState;
 
-  // for padding and sanity checks
+  /* NUMA node of the blocks, if this is a megablock (container == NULL) */
+  uint32_t numaNode;
+
+  // for sanity checks
   uint32_t magic;
 
 } __attribute__((aligned(8)));
@@ -158,6 +172,38 @@ HM_chunk HM_getFreeChunk(GC_state s, size_t bytesRequested);
 HM_chunk HM_allocateChunk(HM_chunkList list, size_t bytesRequested);
 HM_chunk HM_allocateChunkWithPurpose(HM_chunkList list, size_t bytesRequested, enum BlockPurpose purpose);
 
+/* Same as HM_allocateChunk, but backed by a new mapping when large enough;
+ * see allocateFreshBlocks. */
+HM_chunk HM_allocateFreshChunk(HM_chunkList list, size_t bytesRequested);
+
+/* For growing the heap on behalf of the mutator: allocate a heap chunk
+ * (fresh, if requested), or return NULL if that would go past max-heap. */
+HM_chunk HM_tryAllocateHeapChunk(
+  HM_chunkList list,
+  size_t bytesRequested,
+  bool fresh);
+
+/* Keep only the first `bytes` (rounded up to blocks) of a chunk just
+ * allocated into `list` as the chunk proper, and the rest of its mapping in
+ * reserve: the reserve counts neither towards the size of the list nor
+ * against max-heap. For stacks, which then grow in place with
+ * HM_growReservedChunk. */
+void HM_reserveChunkTail(
+  GC_state s,
+  HM_chunkList list,
+  HM_chunk chunk,
+  size_t bytes);
+
+/* Extend a chunk with a reserved tail so that it has at least `bytes`,
+ * taking blocks from the reserve. Returns FALSE, without changing the chunk,
+ * if it has no reserve or the reserve is too small. Going past max-heap this
+ * way doesn't fail, but is reported as for other mutator allocations. */
+bool HM_growReservedChunk(
+  GC_state s,
+  HM_chunkList list,
+  HM_chunk chunk,
+  size_t bytes);
+
 void HM_initChunkList(HM_chunkList list);
 
 void HM_freeChunk(GC_state s, HM_chunk chunk);
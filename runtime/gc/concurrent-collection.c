@@ -27,6 +27,61 @@ void GC_updateObjectHeader(
   }
 }
 
+void parallelMarkField(GC_state s, objptr *field, void *rawArgs);
+
+/* The number of root collections currently open to helpers; see
+ * numOpenParWork in hierarchical-heap-collection.c. */
+static volatile uint32_t numOpenParMark = 0;
+
+void GC_HH_helpConcurrentCollections(GC_state s) {
+  if (0 == s->controls->hhConfig.minParallelCCSize || NULL == s->procStates ||
+      !WT_anyOpen(&numOpenParMark)) {
+    return;
+  }
+
+  for (uint32_t i = 1; i < s->numberOfProcs; i++) {
+    GC_state owner = &(s->procStates[(s->procNumber + i) % s->numberOfProcs]);
+    struct CC_parMark *w = owner->ccParMark;
+
+    if (!WT_tryJoin(&(w->team))) {
+      continue;
+    }
+    ConcurrentCollectArgs *ownerArgs = w->ownerArgs;
+
+    ConcurrentCollectArgs args = {
+      .origList = ownerArgs->origList,
+      .repList = ownerArgs->repList,
+      .toHead = ownerArgs->toHead,
+      .fromHead = ownerArgs->fromHead,
+      .bytesSaved = 0,
+      .numObjectsMarked = 0,
+      .parMark = w
+    };
+    CC_workList_init(s, &(args.worklist));
+
+    struct PerfCounterSample perfStart;
+    bool perfSampling = beginPerfCounterPhase(s, &perfStart);
+    WT_drain(s, &(w->team), &(args.worklist), parallelMarkField, &args);
+    if (perfSampling)
+      endPerfCounterPhase(s, PERF_PHASE_CC, &perfStart);
+
+    CC_workList_free(s, &(args.worklist));
+
+    pthread_mutex_lock(&(w->team.lock));
+    w->bytesSaved += args.bytesSaved;
+    w->numObjectsMarked += args.numObjectsMarked;
+    pthread_mutex_unlock(&(w->team.lock));
+
+    WT_leave(&(w->team));
+
+    LOG(LM_CC_COLLECTION, LL_INFO,
+      "helped root collection of proc %u: marked %zu objects",
+      owner->procNumber,
+      args.numObjectsMarked);
+    return;
+  }
+}
+
 #endif
 
 
@@ -34,6 +89,11 @@ void GC_updateObjectHeader(
 #if (defined (MLTON_GC_INTERNAL_FUNCS))
 #define casCC(F, O, N) ((__sync_val_compare_and_swap(F, O, N)))
 
+/* Number of worklist pops between checks for idle workers, and how many
+ * elements to hand off at a time. */
+#define CC_PAR_SHARE_PERIOD 256
+#define CC_PAR_SHARE_BATCH 32
+
 // void forwardPtrChunk (GC_state s, objptr *opp, void* rawArgs);
 void saveChunk(HM_chunk chunk, ConcurrentCollectArgs* args);
 
@@ -83,7 +143,7 @@ void CC_initStack(GC_state s, ConcurrentPackage cp) {
     return;
   }
 
-  CC_stack* temp  = (struct CC_stack*) malloc(sizeof(struct CC_stack));
+  CC_stack* temp = allocateMetadata(s, sizeof(struct CC_stack));
   CC_stack_init(s, temp);
   cp->rootList = temp;
 }
@@ -107,7 +167,7 @@ void CC_clearStack(GC_state s, ConcurrentPackage cp) {
 void CC_freeStack(GC_state s, ConcurrentPackage cp) {
   if(cp->rootList!=NULL) {
     CC_stack_free(s, cp->rootList);
-    free(cp->rootList);
+    freeMetadata(s, cp->rootList, sizeof(struct CC_stack));
     cp->rootList = NULL;
   }
 }
@@ -177,6 +237,19 @@ void markObj(pointer p) {
   // *headerp = header;
 }
 
+/* Set (or clear) the mark bit, unless some other worker already did.
+ * Returns TRUE if we changed it. */
+bool casMarkBit(pointer p, bool mark) {
+  GC_header header = getHeader(p);
+  while (mark != (0 != (header & MARK_MASK))) {
+    if (__sync_bool_compare_and_swap(getHeaderp(p), header, header ^ MARK_MASK)) {
+      return TRUE;
+    }
+    header = getHeader(p);
+  }
+  return FALSE;
+}
+
 // This function is exactly the same as in chunk.c.
 // The only difference is, it doesn't NULL the levelHead of the unlinking chunk.
 // TODO: replace with HM_unlinkChunkPreserveLevelHead (see chunk.c)
@@ -228,7 +301,15 @@ bool saveNoForward(
   bool chunkSaved = isChunkInToSpace(cand_chunk, args);
   bool chunkOrig  = (chunkSaved)?TRUE:isChunkInFromSpace(cand_chunk, args);
 
-  if(chunkOrig && !chunkSaved) {
+  if(chunkOrig && !chunkSaved && NULL != args->parMark) {
+    /* someone else might be saving the same chunk */
+    pthread_mutex_lock(&(args->parMark->team.lock));
+    if (isChunkInFromSpace(cand_chunk, args)) {
+      saveChunk(cand_chunk, args);
+    }
+    pthread_mutex_unlock(&(args->parMark->team.lock));
+  }
+  else if(chunkOrig && !chunkSaved) {
     assert(isChunkInFromSpace(cand_chunk, args));
     assert(getTransitivePtr(p, rawArgs) == p);
     saveChunk(cand_chunk, args);
@@ -322,12 +403,23 @@ void tryMarkAndAddToWorkList(
   if (!isInScope)
     return;
 
+  if (NULL != args->parMark) {
+    if (casMarkBit(p, TRUE)) {
+      args->bytesSaved += sizeofObject(s, p);
+      args->numObjectsMarked++;
+      if (!HM_getChunkOf(p)->noObjptrs)
+        CC_workList_push(s, &(args->worklist), op);
+    }
+    return;
+  }
+
   if (!CC_isPointerMarked(p)) {
     markObj(p);
     args->bytesSaved += sizeofObject(s, p);
     args->numObjectsMarked++;
     assert(CC_isPointerMarked(p));
-    CC_workList_push(s, &(args->worklist), op);
+    if (!HM_getChunkOf(p)->noObjptrs)
+      CC_workList_push(s, &(args->worklist), op);
   }
 }
 
@@ -346,11 +438,20 @@ void tryUnmarkAndAddToWorkList(
     return;
   }
 
+  if (NULL != args->parMark) {
+    if (casMarkBit(p, FALSE)) {
+      if (!chunk->noObjptrs)
+        CC_workList_push(s, &(args->worklist), op);
+    }
+    return;
+  }
+
   if (CC_isPointerMarked(p)) {
     assert(isChunkInToSpace(chunk, args));
     markObj(p);
     assert(!CC_isPointerMarked(p));
-    CC_workList_push(s, &(args->worklist), op);
+    if (!chunk->noObjptrs)
+      CC_workList_push(s, &(args->worklist), op);
   }
 }
 
@@ -394,6 +495,62 @@ void tryUnmarkAndUnmarkLoop(GC_state s, objptr *opp, objptr op, void* rawArgs) {
   unmarkLoop(s, rawArgs);
 }
 
+struct CC_parMark *CC_newParMark(void) {
+  struct CC_parMark *w = malloc_safe(sizeof(struct CC_parMark));
+  WT_init(&(w->team), CC_PAR_SHARE_PERIOD, CC_PAR_SHARE_BATCH, &numOpenParMark);
+  w->ownerArgs = NULL;
+  w->unmarking = FALSE;
+  w->bytesSaved = 0;
+  w->numObjectsMarked = 0;
+  return w;
+}
+
+/* Same as markLoop (or unmarkLoop), one field at a time, for WT_drain. */
+void parallelMarkField(GC_state s, objptr *field, void *rawArgs) {
+  ConcurrentCollectArgs *args = rawArgs;
+  struct GC_foreachObjptrClosure closure =
+    {.fun = (args->parMark->unmarking ? tryUnmarkAndAddToWorkList : tryMarkAndAddToWorkList),
+     .env = rawArgs};
+  callIfIsObjptr(s, &closure, field);
+}
+
+/* Owner side: open up the (un)mark phase to helpers, drain the worklist
+ * together, and wait for the helpers to leave. With a deadline, everyone
+ * stops once it has passed, and the unfinished work is put back on the
+ * owner's worklist. Returns whether the worklist was drained. */
+bool markInParallel(
+  GC_state s,
+  ConcurrentCollectArgs* args,
+  bool unmarking,
+  struct timespec *deadline)
+{
+  struct CC_parMark *w = s->ccParMark;
+  assert(NULL == args->parMark);
+
+  w->ownerArgs = args;
+  w->unmarking = unmarking;
+  w->bytesSaved = 0;
+  w->numObjectsMarked = 0;
+  args->parMark = w;
+
+  WT_open(s, &(w->team), deadline);
+  WT_drain(s, &(w->team), &(args->worklist), parallelMarkField, args);
+  bool drained = WT_close(s, &(w->team), &(args->worklist));
+  w->ownerArgs = NULL;
+  args->parMark = NULL;
+
+  args->bytesSaved += w->bytesSaved;
+  args->numObjectsMarked += w->numObjectsMarked;
+
+  LOG(LM_CC_COLLECTION, LL_INFO,
+    "parallel %s: helpers marked %zu objects%s",
+    (unmarking ? "unmark" : "mark"),
+    w->numObjectsMarked,
+    (drained ? "" : " (stopped at end of slice)"));
+
+  return drained;
+}
+
 #if 0
 void forwardPtrChunk (GC_state s, objptr *opp, void* rawArgs) {
   objptr op = *opp;
@@ -416,9 +573,9 @@ void forwardPtrChunk (GC_state s, objptr *opp, void* rawArgs) {
 
 void forwardPinned(GC_state s, HM_remembered remElem, void* rawArgs) {
   objptr src = remElem->object;
-  tryMarkAndMarkLoop(s, &src, src, rawArgs);
+  tryMarkAndAddToWorkList(s, &src, src, rawArgs);
   if (remElem->from != BOGUS_OBJPTR) {
-    tryMarkAndMarkLoop(s, &(remElem->from), remElem->from, rawArgs);
+    tryMarkAndAddToWorkList(s, &(remElem->from), remElem->from, rawArgs);
   }
 
 #if 0
@@ -499,9 +656,9 @@ void unmarkPinned(
 {
   objptr src = remElem->object;
   assert(!(HM_getChunkOf(objptrToPointer(src, NULL))->pinnedDuringCollection));
-  tryUnmarkAndUnmarkLoop(s, &src, src, rawArgs);
+  tryUnmarkAndAddToWorkList(s, &src, src, rawArgs);
   if (remElem->from != BOGUS_OBJPTR) {
-    tryUnmarkAndUnmarkLoop(s, &(remElem->from), remElem->from, rawArgs);
+    tryUnmarkAndAddToWorkList(s, &(remElem->from), remElem->from, rawArgs);
   }
   // unmarkPtrChunk(s, &src, rawArgs);
   // unmarkPtrChunk(s, &(remElem->from), rawArgs);
@@ -526,7 +683,8 @@ void unmarkPinned(
 
 // This function does more than forwardPtrChunk.
 // It scans the object pointed by the pointer even if its not in scope.
-// Recursively however it only calls forwardPtrChunk and not itself
+// Recursively however it only calls forwardPtrChunk and not itself.
+// The object is only pushed; the caller drains the worklist afterwards.
 void forceForward(GC_state s, objptr *opp, void* rawArgs) {
   ConcurrentCollectArgs *args = (ConcurrentCollectArgs*)rawArgs;
   objptr op = *opp;
@@ -545,7 +703,6 @@ void forceForward(GC_state s, objptr *opp, void* rawArgs) {
   }
 
   CC_workList_push(s, &(args->worklist), op);
-  markLoop(s, rawArgs);
 }
 
 void forceUnmark (GC_state s, objptr* opp, void* rawArgs) {
@@ -562,7 +719,6 @@ void forceUnmark (GC_state s, objptr* opp, void* rawArgs) {
   }
 
   CC_workList_push(s, &(args->worklist), op);
-  unmarkLoop(s, rawArgs);
 }
 
 void ensureCallSanity(
@@ -627,56 +783,6 @@ bool claimHeap(HM_HierarchicalHeap heap) {
   return TRUE;
 }
 
-void CC_collectAtRoot(pointer threadp, pointer hhp) {
-  GC_state s = pthread_getspecific (gcstate_key);
-  GC_thread thread = threadObjptrToStruct(s, pointerToObjptr(threadp, NULL));
-  HM_HierarchicalHeap heap = (HM_HierarchicalHeap)hhp;
-
-  if (!checkLocalScheduler(s) || thread->currentDepth<=0) {
-    return;
-  }
-
-  if (!claimHeap(heap)) {
-    return;
-  }
-
-  // for exiting even if CC is going on.
-  assert(NULL == s->currentCCTargetHH);
-  s->currentCCTargetHH = heap;
-  // assert(!s->amInCC);
-  // s->amInCC = TRUE;
-
-#if ASSERT
-  for (int other = 0; other < (int)s->numberOfProcs; other++) {
-    if (other != s->procNumber)
-      assert(heap != s->procStates[other].currentCCTargetHH);
-  }
-#endif
-
-  size_t beforeSize = HM_getChunkListSize(HM_HH_getChunkList(heap));
-  size_t live = 0;
-  size_t numObjectsMarked = 0;
-  CC_collectWithRoots(s, heap, thread, &live, &numObjectsMarked);
-  size_t afterSize = HM_getChunkListSize(HM_HH_getChunkList(heap));
-
-  size_t diff = beforeSize > afterSize ? beforeSize - afterSize : 0;
-
-  LOG(LM_CC_COLLECTION, LL_INFO,
-    "finished at depth %u. before: %zu after: %zu (-%.01lf%%) live: %zu (%.01lf%% fragmented) objects: %zu",
-    heap->depth,
-    beforeSize,
-    afterSize,
-    100.0 * ((double)diff / (double)beforeSize),
-    live,
-    100.0 * (1.0 - (double)live / (double)afterSize),
-    numObjectsMarked);
-
-  // HM_HH_getConcurrentPack(heap)->ccstate = CC_UNREG;
-  __atomic_store_n(&(HM_HH_getConcurrentPack(heap)->ccstate), CC_DONE, __ATOMIC_SEQ_CST);
-  // s->amInCC = FALSE;
-  s->currentCCTargetHH = NULL;
-}
-
 uint32_t minPrivateLevel(GC_state s) {
   uint64_t topval = *(uint64_t*)objptrToPointer(s->wsQueueTop, NULL);
   uint32_t shallowestPrivateLevel = UNPACK_IDX(topval);
@@ -685,7 +791,11 @@ uint32_t minPrivateLevel(GC_state s) {
 }
 
 void CC_collectAtPublicLevel(GC_state s, GC_thread thread, uint32_t depth) {
-  checkLocalScheduler(s);
+  if (!checkLocalScheduler(s)) {
+    return;
+  }
+  HM_HH_flushRememberBuffer(s);
+  s->writeBarrierLevelHead = NULL;
   if (thread->currentDepth <= 1
     || depth <= 0
     || depth >= thread->currentDepth
@@ -700,7 +810,10 @@ void CC_collectAtPublicLevel(GC_state s, GC_thread thread, uint32_t depth) {
     return;
   }
 
-  // collect only if the heap is above a threshold size
+  /* collect only if the heap is above a threshold size. This is never
+   * sliced: it runs in the middle of an allocation that is waiting for the
+   * space, with no task to resume a paused collection later, and the caller
+   * is not at a point where it could let the scheduler run anything else. */
   if (HM_getChunkListSize(&(heap->chunkList)) >= 2 * HM_BLOCK_SIZE) {
     assert(getThreadCurrent(s) == thread);
     CC_collectWithRoots(s, heap, thread, NULL, NULL);
@@ -913,22 +1026,53 @@ void CC_filterDownPointers(GC_state s, HM_chunkList x, HM_HierarchicalHeap hh){
 #endif
 
 
-void CC_collectWithRoots(
+/* Number of worklist pops between checks of the slice deadline. */
+#define CC_SLICE_CHECK_PERIOD 256
+
+static volatile uint32_t CC_numInProgress = 0;
+
+uint32_t GC_numCCsInProgress(__attribute__((unused)) GC_state s) {
+  return __atomic_load_n(&CC_numInProgress, __ATOMIC_RELAXED);
+}
+
+
+/* Like markLoop (or unmarkLoop), but stops early once the deadline (if any)
+ * has passed. Returns whether the worklist was drained. */
+static bool drainWorkList(
   GC_state s,
-  HM_HierarchicalHeap targetHH,
-  __attribute__((unused)) GC_thread thread,
-  size_t *outputBytesSaved,
-  size_t *outputNumObjectsMarked)
+  ConcurrentCollectArgs* args,
+  bool unmarking,
+  struct timespec *deadline)
 {
-  getStackCurrent(s)->used = sizeofGCStateCurrentStackUsed(s);
-  getThreadCurrent(s)->exnStack = s->exnStack;
-  HM_HH_updateValues(getThreadCurrent(s), s->frontier);
+  struct GC_foreachObjptrClosure closure =
+    {.fun = (unmarking ? tryUnmarkAndAddToWorkList : tryMarkAndAddToWorkList),
+     .env = (void*)args};
+  CC_workList worklist = &(args->worklist);
+  size_t popsSinceCheck = 0;
 
-  struct timespec startTime;
-  struct timespec stopTime;
+  objptr* current = CC_workList_pop(s, worklist);
+  while (NULL != current) {
+    callIfIsObjptr(s, &closure, current);
+
+    if (NULL != deadline && ++popsSinceCheck >= CC_SLICE_CHECK_PERIOD) {
+      popsSinceCheck = 0;
+      if (WT_pastDeadline(deadline))
+        return CC_workList_isEmpty(s, worklist);
+    }
+    current = CC_workList_pop(s, worklist);
+  }
+
+  assert(CC_workList_isEmpty(s, worklist));
+  return TRUE;
+}
 
-  timespec_now(&startTime);
 
+/* Set up the state for a collection of targetHH. All of the work, starting
+ * with forwarding the roots, is done by runCollection. */
+static struct CC_collection* beginCollection(
+  GC_state s,
+  HM_HierarchicalHeap targetHH)
+{
   LOG(LM_CC_COLLECTION, LL_INFO,
     "CC collecting heap %p at depth %u",
     (void*)targetHH,
@@ -942,12 +1086,18 @@ void CC_collectWithRoots(
   // chunks in which all objects are garbage. Before exiting, chunks in
   // origList are added to the free list.
 
-  uint32_t initialDepth = HM_HH_getDepth(targetHH);
+  struct CC_collection *c = allocateMetadata(s, sizeof(struct CC_collection));
+  c->phase = CC_PHASE_ROOTS;
+  c->targetHH = targetHH;
+  c->initialDepth = HM_HH_getDepth(targetHH);
+  c->numSlices = 0;
+  c->holdsEpochs = FALSE;
 
-  struct HM_chunkList _repList;
-  HM_chunkList repList = &(_repList);
+  HM_chunkList repList = &(c->repList);
   HM_initChunkList(repList);
-  HM_chunkList origList = HM_HH_getChunkList(targetHH);
+  c->origList = HM_HH_getChunkList(targetHH);
+  HM_chunkList origList = c->origList;
+  HM_initChunkList(&(c->removedFromCCBag));
 
   HM_assertChunkListInvariants(origList);
 
@@ -955,170 +1105,38 @@ void CC_collectWithRoots(
     .origList = origList,
     .repList  = repList,
     .toHead = (void*)repList,
-    .fromHead = (void*) &(origList),
+    .fromHead = (void*) &(c->origList),
     .bytesSaved = 0,
-    .numObjectsMarked = 0
+    .numObjectsMarked = 0,
+    .parMark = NULL
   };
-  CC_workList_init(s, &(lists.worklist));
-
-  HH_EBR_enterQuiescentState(s);
-
-  // JATIN_NOTE: Some HM_hierarchical objects in origList
-  // might not be reachable from the mutator roots.
-  // So, I assign the levelHead of all chunks in the list to targetHH.
-  // Then I explicitly preserve the chunk that contains targetHH.
-  for(HM_chunk T = HM_getChunkListFirstChunk(origList); T!=NULL; T = T->nextChunk) {
-#if ASSERT2
-    // there were some issues with stack chunks
-    // preserving for future debugging
-      HM_chunk stackChunk =  HM_getChunkOf(thread->stack);
-      if (T!=stackChunk && HM_getLevelHead(T) != targetHH) {
-        printf("%s\n", "this is failing");
-        assert(0);
-      }
-#endif
-    assert(T->tmpHeap == NULL);
-    T->tmpHeap = lists.fromHead;
-    T->levelHead = HM_HH_getUFNode(targetHH);
-    assert(T->levelHead->representative == NULL);
-    assert(T->levelHead->payload == targetHH);
-  }
-
-  // forward down pointers
-  // struct HM_chunkList downPtrs;
-  // HM_initChunkList(&downPtrs);
-  // CC_filterDownPointers(s, &downPtrs, targetHH);
-
-  // struct HM_chunkList pinnedChunks;
-  // HM_initChunkList(&pinnedChunks);
-  CC_filterPinned(s, initialDepth, targetHH, lists.fromHead, lists.toHead);
-
-  struct HM_foreachDownptrClosure forwardPinnedClosure =
-    {.fun = forwardPinned, .env = (void*)&lists};
-  HM_foreachRemembered(s, HM_HH_getRemSet(targetHH), &forwardPinnedClosure, false);
-
-  // forward closures, stack and deque?
-  forceForward(s, &(cp->snapLeft), &lists);
-  forceForward(s, &(cp->snapRight), &lists);
-  forceForward(s, &(cp->snapTemp), &lists);
-  // forceForward(s, &(s->wsQueue), &lists);
-  forceForward(s, &(cp->stack), &lists);
-
-  markLoop(s, &lists);
-
-  // JATIN_NOTE: This is important because the stack object of the thread we are collecting
-  // often changes the level it is at. So it might in fact be at depth = 1.
-  // It is important that we only mark the stack and not scan it.
-  // Scanning the stack races with the thread using it.
-
-
-  struct HM_chunkList removedFromCCBag_;
-  HM_chunkList removedFromCCBag = &removedFromCCBag_;
-  HM_initChunkList(removedFromCCBag);
-
-  struct HM_chunkList tempRemovedFromCCBag_;
-  HM_chunkList tempRemovedFromCCBag = &tempRemovedFromCCBag_;
-  HM_initChunkList(tempRemovedFromCCBag);
-
-  while (!CC_closeStack(cp, tempRemovedFromCCBag)) {
-    forEachObjptrInCCStackBag(
-      s,
-      tempRemovedFromCCBag,
-      tryMarkAndMarkLoop,
-      &lists);
-    HM_appendChunkList(removedFromCCBag, tempRemovedFromCCBag);
-    HM_initChunkList(tempRemovedFromCCBag);
-
-    markLoop(s, &lists);
-  }
-
-  assert(CC_workList_isEmpty(s, &(lists.worklist)));
-  assert(NULL == tempRemovedFromCCBag->firstChunk);
-
-  // saveNoForward(s, (void*)(thread->stack), &lists);
-  // saveNoForward(s, (void*)thread, &lists);
-
-  // forEachObjptrinStack(s, cp->rootList, forwardPtrChunk, &lists);
-
-// #if ASSERT
-//   if (HM_HH_getDepth(targetHH) != 1){
-//     struct GC_foreachObjptrClosure printObjPtrInScopeClosure =
-//     {.fun = printObjPtrInScopeFunction, .env =  &lists};
-//     foreachObjptrInObject(
-//       s,
-//       objptrToPointer(thread->stack, NULL),
-//       &trueObjptrPredicateClosure,
-//       &printObjPtrInScopeClosure,
-//       FALSE);
-//   }
-// #endif
-
-  struct HM_foreachDownptrClosure unmarkPinnedClosure =
-    {.fun = unmarkPinned, .env = &lists};
-  HM_foreachRemembered(s, HM_HH_getRemSet(targetHH), &unmarkPinnedClosure, false);
-
-  forceUnmark(s, &(cp->snapLeft), &lists);
-  forceUnmark(s, &(cp->snapRight), &lists);
-  forceUnmark(s, &(cp->snapTemp), &lists);
-  // forceUnmark(s, &(s->wsQueue), &lists);
-  forceUnmark(s, &(cp->stack), &lists);
-
-  unmarkLoop(s, &lists);
-
-  // forEachObjptrinStack(s, cp->rootList, unmarkPtrChunk, &lists);
-  forEachObjptrInCCStackBag(s, removedFromCCBag, tryUnmarkAndUnmarkLoop, &lists);
-  unmarkLoop(s, &lists);
+  c->lists = lists;
+  CC_workList_init(s, &(c->lists.worklist));
+
+  // Share the (un)marking of the roots with idle processors if the heap is
+  // big enough. The rest (the CC stack bag) is marked by this processor only.
+  c->parallel =
+    0 != s->controls->hhConfig.minParallelCCSize &&
+    HM_getChunkListSize(origList) >= s->controls->hhConfig.minParallelCCSize &&
+    s->numberOfProcs > 1;
+
+  __sync_fetch_and_add(&CC_numInProgress, 1);
+  return c;
+}
 
-  HM_freeChunksInListWithInfo(s, removedFromCCBag, NULL, BLOCK_FOR_FORGOTTEN_SET);
 
-  assert(CC_workList_isEmpty(s, &(lists.worklist)));
-  CC_workList_free(s, &(lists.worklist));
+/* Free the chunks that were not reached, and hand the rest back to the
+ * target heap. */
+static void finishCollection(GC_state s, struct CC_collection *c) {
+  HM_HierarchicalHeap targetHH = c->targetHH;
+  ConcurrentPackage cp = HM_HH_getConcurrentPack(targetHH);
+  HM_chunkList origList = c->origList;
+  HM_chunkList repList = &(c->repList);
 
-#if ASSERT2 // just contains code that is sometimes useful for debugging.
-  HM_assertChunkListInvariants(origList);
-  HM_assertChunkListInvariants(repList);
-
-  int lenFree = 0;
-  int lenRep = 0;
-  HM_chunk Q = origList->firstChunk;
-  // assert(Q==NULL);
-  while(Q!=NULL) {
-    lenFree++;
-    Q = Q->nextChunk;
-  }
+  HM_freeChunksInListWithInfo(s, &(c->removedFromCCBag), NULL, BLOCK_FOR_FORGOTTEN_SET);
 
-  Q = repList->firstChunk;
-  while(Q!=NULL){
-    lenRep++;
-    assert(Q->tmpHeap == lists.toHead);
-    assert(HM_getLevelHead(Q) == targetHH);
-    Q = Q->nextChunk;
-  }
-  assert(lenRep+lenFree == lenOrig);
-  printf("%s %d \n", "Chunks Collected = ", lenFree);
-
-  printf("%s", "collected chunks: ");
-  for(HM_chunk chunk = origList->firstChunk; chunk!=NULL; chunk = chunk->nextChunk){
-    printf("%p", chunk);
-    assert(chunk->tmpHeap == lists.fromHead);
-    assert(HM_getLevelHead(chunk) == targetHH);
-  }
-  printf("\n");
-  // safety code
-  int countStopGapChunks = 0;
-  int stopGapMem = 0;
-  HM_chunk chunk = origList->firstChunk;
-  while (chunk!=NULL)  {
-    HM_chunk tChunk = chunk->nextChunk;
-    assert(chunk->tmpHeap == lists.fromHead);
-    if(chunk->startGap != 0) {
-      saveChunk(chunk, &lists);
-      countStopGapChunks++;
-      stopGapMem+=(HM_getChunkSize(chunk));
-    }
-    chunk=tChunk;
-  }
-#endif
+  assert(CC_workList_isEmpty(s, &(c->lists.worklist)));
+  CC_workList_free(s, &(c->lists.worklist));
 
   uint64_t bytesSaved =  HM_getChunkListUsedSize(repList);
   uint64_t bytesScanned =  HM_getChunkListUsedSize(repList)
@@ -1146,7 +1164,7 @@ void CC_collectWithRoots(
   uint32_t finalDepth = HM_HH_getDepth(targetHH);
 
   struct CC_chunkInfo info =
-    {.initialDepth = initialDepth,
+    {.initialDepth = c->initialDepth,
      .finalDepth = finalDepth,
      .procNum = s->procNumber,
      .freedType = CC_FREED_NORMAL_CHUNK};
@@ -1181,7 +1199,7 @@ void CC_collectWithRoots(
 
 // #if ASSERT
 //   struct HM_foreachDownptrClosure checkRemEntryClosure =
-//     {.fun = checkRemEntry, .env = &lists};
+//     {.fun = checkRemEntry, .env = &(c->lists)};
 //   HM_foreachRemembered(s, HM_HH_getRemSet(targetHH), &checkRemEntryClosure);
 // #endif
 
@@ -1194,24 +1212,340 @@ void CC_collectWithRoots(
 
   HM_assertChunkListInvariants(origList);
 
-  timespec_now(&stopTime);
-  timespec_sub(&stopTime, &startTime);
-  timespec_add(&(s->cumulativeStatistics->timeCC), &stopTime);
   s->cumulativeStatistics->numCCs++;
   assert(bytesScanned >= bytesSaved);
   uintmax_t bytesReclaimed = bytesScanned-bytesSaved;
   s->cumulativeStatistics->bytesInScopeForCC += bytesScanned;
   s->cumulativeStatistics->bytesReclaimedByCC += bytesReclaimed;
+  HM_HH_updateAdaptivePolicy(s);
+
+  __sync_fetch_and_sub(&CC_numInProgress, 1);
+}
+
+
+/* Run the collection until it finishes or, if budgetNs is non-zero, until
+ * about budgetNs nanoseconds have passed. Returns whether it finished; if
+ * not, call again later to resume it. */
+static bool runCollection(
+  GC_state s,
+  struct CC_collection *c,
+  uint64_t budgetNs)
+{
+  getStackCurrent(s)->used = sizeofGCStateCurrentStackUsed(s);
+  getThreadCurrent(s)->exnStack = s->exnStack;
+  HM_HH_updateValues(getThreadCurrent(s), s->frontier);
+
+  struct timespec startTime;
+  struct timespec stopTime;
+  timespec_now(&startTime);
+  struct PerfCounterSample perfStart;
+  bool perfSampling = beginPerfCounterPhase(s, &perfStart);
+
+  struct timespec _deadline;
+  struct timespec *deadline = NULL;
+  if (0 != budgetNs) {
+    _deadline = startTime;
+    _deadline.tv_sec += budgetNs / 1000000000;
+    _deadline.tv_nsec += budgetNs % 1000000000;
+    if (_deadline.tv_nsec >= 1000000000) {
+      _deadline.tv_sec++;
+      _deadline.tv_nsec -= 1000000000;
+    }
+    deadline = &_deadline;
+  }
+
+  HH_EBR_enterQuiescentState(s);
+
+  HM_HierarchicalHeap targetHH = c->targetHH;
+  ConcurrentPackage cp = HM_HH_getConcurrentPack(targetHH);
+  ConcurrentCollectArgs *lists = &(c->lists);
+  bool outOfTime = FALSE;
+
+  c->numSlices++;
+  s->cumulativeStatistics->numCCSlices++;
+
+  while (!outOfTime && CC_PHASE_FINISH != c->phase) {
+    switch (c->phase) {
+
+    case CC_PHASE_ROOTS: {
+      // JATIN_NOTE: Some HM_hierarchical objects in origList
+      // might not be reachable from the mutator roots.
+      // So, I assign the levelHead of all chunks in the list to targetHH.
+      // Then I explicitly preserve the chunk that contains targetHH.
+      for(HM_chunk T = HM_getChunkListFirstChunk(c->origList); T!=NULL; T = T->nextChunk) {
+        assert(T->tmpHeap == NULL);
+        T->tmpHeap = lists->fromHead;
+        T->levelHead = HM_HH_getUFNode(targetHH);
+        assert(T->levelHead->representative == NULL);
+        assert(T->levelHead->payload == targetHH);
+      }
+
+      // forward down pointers
+      // struct HM_chunkList downPtrs;
+      // HM_initChunkList(&downPtrs);
+      // CC_filterDownPointers(s, &downPtrs, targetHH);
+
+      // struct HM_chunkList pinnedChunks;
+      // HM_initChunkList(&pinnedChunks);
+      CC_filterPinned(s, c->initialDepth, targetHH, lists->fromHead, lists->toHead);
+
+      struct HM_foreachDownptrClosure forwardPinnedClosure =
+        {.fun = forwardPinned, .env = (void*)lists};
+      HM_foreachRemembered(s, HM_HH_getRemSet(targetHH), &forwardPinnedClosure, false);
+
+      // forward closures, stack and deque?
+      forceForward(s, &(cp->snapLeft), lists);
+      forceForward(s, &(cp->snapRight), lists);
+      forceForward(s, &(cp->snapTemp), lists);
+      // forceForward(s, &(s->wsQueue), lists);
+      forceForward(s, &(cp->stack), lists);
+
+      c->phase = CC_PHASE_MARK;
+      break;
+    }
+
+    case CC_PHASE_MARK:
+    case CC_PHASE_MARK_BAG_DRAIN: {
+      bool drained =
+        (CC_PHASE_MARK == c->phase && c->parallel)
+        ? markInParallel(s, lists, FALSE, deadline)
+        : drainWorkList(s, lists, FALSE, deadline);
+      if (drained)
+        c->phase = CC_PHASE_MARK_BAG;
+      else
+        outOfTime = TRUE;
+      break;
+    }
+
+    case CC_PHASE_MARK_BAG: {
+      // JATIN_NOTE: This is important because the stack object of the thread we are collecting
+      // often changes the level it is at. So it might in fact be at depth = 1.
+      // It is important that we only mark the stack and not scan it.
+      // Scanning the stack races with the thread using it.
+      assert(CC_workList_isEmpty(s, &(lists->worklist)));
+
+      struct HM_chunkList tempRemovedFromCCBag_;
+      HM_chunkList tempRemovedFromCCBag = &tempRemovedFromCCBag_;
+      HM_initChunkList(tempRemovedFromCCBag);
+
+      if (!CC_closeStack(cp, tempRemovedFromCCBag)) {
+        forEachObjptrInCCStackBag(
+          s,
+          tempRemovedFromCCBag,
+          tryMarkAndAddToWorkList,
+          lists);
+        HM_appendChunkList(&(c->removedFromCCBag), tempRemovedFromCCBag);
+        c->phase = CC_PHASE_MARK_BAG_DRAIN;
+        break;
+      }
+      assert(NULL == tempRemovedFromCCBag->firstChunk);
+
+      // saveNoForward(s, (void*)(thread->stack), lists);
+      // saveNoForward(s, (void*)thread, lists);
+
+      // forEachObjptrinStack(s, cp->rootList, forwardPtrChunk, lists);
+
+      struct HM_foreachDownptrClosure unmarkPinnedClosure =
+        {.fun = unmarkPinned, .env = lists};
+      HM_foreachRemembered(s, HM_HH_getRemSet(targetHH), &unmarkPinnedClosure, false);
+
+      forceUnmark(s, &(cp->snapLeft), lists);
+      forceUnmark(s, &(cp->snapRight), lists);
+      forceUnmark(s, &(cp->snapTemp), lists);
+      // forceUnmark(s, &(s->wsQueue), lists);
+      forceUnmark(s, &(cp->stack), lists);
+
+      c->phase = CC_PHASE_UNMARK;
+      break;
+    }
+
+    case CC_PHASE_UNMARK: {
+      bool drained =
+        c->parallel
+        ? markInParallel(s, lists, TRUE, deadline)
+        : drainWorkList(s, lists, TRUE, deadline);
+      if (!drained) {
+        outOfTime = TRUE;
+        break;
+      }
+
+      // forEachObjptrinStack(s, cp->rootList, unmarkPtrChunk, lists);
+      forEachObjptrInCCStackBag(
+        s,
+        &(c->removedFromCCBag),
+        tryUnmarkAndAddToWorkList,
+        lists);
+      c->phase = CC_PHASE_UNMARK_BAG;
+      break;
+    }
+
+    case CC_PHASE_UNMARK_BAG:
+      if (drainWorkList(s, lists, TRUE, deadline))
+        c->phase = CC_PHASE_FINISH;
+      else
+        outOfTime = TRUE;
+      break;
+
+    case CC_PHASE_FINISH:
+      break;
+    }
+
+    if (!outOfTime && NULL != deadline && CC_PHASE_FINISH != c->phase)
+      outOfTime = WT_pastDeadline(deadline);
+  }
+
+  bool finished = (CC_PHASE_FINISH == c->phase);
+  if (finished) {
+    finishCollection(s, c);
+    if (c->holdsEpochs) {
+      EBR_releaseEpoch(s->hhEBR);
+      EBR_releaseEpoch(s->hmEBR);
+    }
+  } else {
+    HH_EBR_leaveQuiescentState(s);
+    if (!c->holdsEpochs) {
+      EBR_holdEpoch(s->hhEBR);
+      EBR_holdEpoch(s->hmEBR);
+      c->holdsEpochs = TRUE;
+      timespec_now(&(c->holdStart));
+    }
+  }
+
+  timespec_now(&stopTime);
+  timespec_sub(&stopTime, &startTime);
+  timespec_add(&(s->cumulativeStatistics->timeCC), &stopTime);
+  if (perfSampling)
+    endPerfCounterPhase(s, PERF_PHASE_CC, &perfStart);
+
+  return finished;
+}
+
+
+/* While a collection is paused, nothing retired by anyone is reclaimed (see
+ * holdsEpochs). Releasing the hold between slices would mean re-validating
+ * every chunk and heap record that the worklist refers to, so instead the
+ * hold is bounded: once a collection has been paused for this long (or for
+ * 16 slices, if that is longer), its next slice runs it to the end. This is
+ * only checked when the collection is resumed, so the hold still lasts as
+ * long as the task that its worker ran in between, unless another idle
+ * worker steals the collection first. */
+#define CC_MAX_EPOCH_HOLD_NS 10000000
+
+static bool heldTooLong(struct CC_collection *c, uint64_t budgetNs) {
+  struct timespec held;
+  timespec_now(&held);
+  timespec_sub(&held, &(c->holdStart));
+  uint64_t heldNs = (uint64_t)held.tv_sec * 1000000000 + (uint64_t)held.tv_nsec;
+  uint64_t limitNs = 16 * budgetNs;
+  if (limitNs < CC_MAX_EPOCH_HOLD_NS)
+    limitNs = CC_MAX_EPOCH_HOLD_NS;
+  return heldNs >= limitNs;
+}
+
+static void freeCollection(GC_state s, struct CC_collection *c) {
+  freeMetadata(s, c, sizeof(struct CC_collection));
+}
+
+
+void CC_collectWithRoots(
+  GC_state s,
+  HM_HierarchicalHeap targetHH,
+  __attribute__((unused)) GC_thread thread,
+  size_t *outputBytesSaved,
+  size_t *outputNumObjectsMarked)
+{
+  struct CC_collection *c = beginCollection(s, targetHH);
+  bool finished = runCollection(s, c, 0);
+  assert(finished);
+  (void)finished;
 
   if (outputBytesSaved != NULL) {
-    *outputBytesSaved = lists.bytesSaved;
+    *outputBytesSaved = c->lists.bytesSaved;
   }
 
   if (outputNumObjectsMarked != NULL) {
-    *outputNumObjectsMarked = lists.numObjectsMarked;
+    *outputNumObjectsMarked = c->lists.numObjectsMarked;
   }
-  
-  return;
+
+  freeCollection(s, c);
 }
 
+Bool_t CC_collectAtRoot(pointer threadp, pointer hhp) {
+  GC_state s = pthread_getspecific (gcstate_key);
+  GC_thread thread = threadObjptrToStruct(s, pointerToObjptr(threadp, NULL));
+  HM_HierarchicalHeap heap = (HM_HierarchicalHeap)hhp;
+  ConcurrentPackage cp = HM_HH_getConcurrentPack(heap);
+  struct CC_collection *c = cp->collection;
+
+  if (NULL == c) {
+    if (!checkLocalScheduler(s) || thread->currentDepth<=0) {
+      return TRUE;
+    }
+
+    if (!claimHeap(heap)) {
+      return TRUE;
+    }
+
+    c = beginCollection(s, heap);
+    cp->collection = c;
+  }
+  assert(HM_HH_getConcurrentPack(heap)->ccstate == CC_COLLECTING);
+
+  // for exiting even if CC is going on.
+  assert(NULL == s->currentCCTargetHH);
+  s->currentCCTargetHH = heap;
+  // assert(!s->amInCC);
+  // s->amInCC = TRUE;
+
+#if ASSERT
+  for (int other = 0; other < (int)s->numberOfProcs; other++) {
+    if (other != s->procNumber)
+      assert(heap != s->procStates[other].currentCCTargetHH);
+  }
+#endif
+
+  if (0 == c->numSlices)
+    c->beforeSize = HM_getChunkListSize(HM_HH_getChunkList(heap));
+
+  uint64_t budgetNs =
+    __atomic_load_n(&(s->controls->hhConfig.ccSliceTime), __ATOMIC_RELAXED);
+  if (0 != budgetNs && c->holdsEpochs && heldTooLong(c, budgetNs))
+    budgetNs = 0;
+  bool finished = runCollection(s, c, budgetNs);
+  s->currentCCTargetHH = NULL;
+
+  if (!finished) {
+    LOG(LM_CC_COLLECTION, LL_DEBUG,
+      "paused at depth %u after slice %zu",
+      heap->depth,
+      c->numSlices);
+    return FALSE;
+  }
+
+  size_t beforeSize = c->beforeSize;
+  size_t live = c->lists.bytesSaved;
+  size_t numObjectsMarked = c->lists.numObjectsMarked;
+  size_t afterSize = HM_getChunkListSize(HM_HH_getChunkList(heap));
+
+  size_t diff = beforeSize > afterSize ? beforeSize - afterSize : 0;
+
+  LOG(LM_CC_COLLECTION, LL_INFO,
+    "finished at depth %u in %zu slices. before: %zu after: %zu (-%.01lf%%) live: %zu (%.01lf%% fragmented) objects: %zu",
+    heap->depth,
+    c->numSlices,
+    beforeSize,
+    afterSize,
+    100.0 * ((double)diff / (double)beforeSize),
+    live,
+    100.0 * (1.0 - (double)live / (double)afterSize),
+    numObjectsMarked);
+
+  cp->collection = NULL;
+  freeCollection(s, c);
+
+  // HM_HH_getConcurrentPack(heap)->ccstate = CC_UNREG;
+  __atomic_store_n(&(HM_HH_getConcurrentPack(heap)->ccstate), CC_DONE, __ATOMIC_SEQ_CST);
+  // s->amInCC = FALSE;
+  return TRUE;
+}
 #endif
@@ -15,6 +15,7 @@
 #include "objptr.h"
 #include "deferred-promote.h"
 #include "cc-work-list.h"
+#include "work-team.h"
 // #include "logger.h"
 
 
@@ -29,8 +30,71 @@ typedef struct ConcurrentCollectArgs {
 	void* fromHead;
   size_t bytesSaved;
 	size_t numObjectsMarked;
+  /* non-NULL while marking (or unmarking) is shared with helpers; see
+   * CC_parMark. Chunks are then saved under the lock, and mark bits are
+   * flipped with a CAS so that each object is traced by exactly one worker. */
+  struct CC_parMark *parMark;
 } ConcurrentCollectArgs;
 
+/* The mark (or unmark) phase of a root collection which is opened up to idle
+ * processors. Like HM_HHC_parWork, each processor has one of these which is
+ * reused for all of its collections. Helpers trace with their own worklists
+ * and take batches of work from the shared pool, which the owner refills
+ * whenever some workers are idle.
+ */
+struct CC_parMark {
+  /* When a root collection runs in slices, the team has the end of the
+   * owner's slice as its deadline. */
+  struct GC_workTeam team;
+
+  /* everything below is protected by the team's lock */
+  ConcurrentCollectArgs *ownerArgs;
+  bool unmarking;
+
+  size_t bytesSaved;
+  size_t numObjectsMarked;
+};
+
+
+enum CC_collectionPhase {
+  CC_PHASE_ROOTS,          /* forward the pinned objects and the snapshot */
+  CC_PHASE_MARK,           /* trace from the roots */
+  CC_PHASE_MARK_BAG,       /* take the next batch of the CC stack bag */
+  CC_PHASE_MARK_BAG_DRAIN, /* trace from that batch */
+  CC_PHASE_UNMARK,         /* clear mark bits from the roots */
+  CC_PHASE_UNMARK_BAG,     /* clear mark bits from everything taken from the bag */
+  CC_PHASE_FINISH
+};
+
+/* A root collection in progress. A collection that runs in slices (see
+ * hhConfig.ccSliceTime) is parked in the ConcurrentPackage of its target
+ * heap between slices; everything the tracing needs to resume lives here,
+ * so a slice may return to the scheduler at any point between two pops of
+ * the worklist. */
+struct CC_collection {
+  enum CC_collectionPhase phase;
+  struct HM_HierarchicalHeap *targetHH;
+  uint32_t initialDepth;
+  bool parallel;
+  size_t numSlices;
+  size_t beforeSize;
+
+  /* Once paused, the worklist may point into chunks and heap records that
+   * the mutator (or a local collection) retires before the next slice, so
+   * the EBR epochs are held (since holdStart) until the collection
+   * finishes. */
+  bool holdsEpochs;
+  struct timespec holdStart;
+
+  /* lists.toHead and lists.fromHead point at these, so that chunks can be
+   * tagged with them */
+  struct HM_chunkList repList;
+  HM_chunkList origList;
+
+  struct HM_chunkList removedFromCCBag;
+  ConcurrentCollectArgs lists;
+};
+
 
 enum CCState{
   CC_UNREG,
@@ -58,6 +122,9 @@ typedef struct ConcurrentPackage {
 	size_t bytesAllocatedSinceLastCollection;
 	size_t bytesSurvivedLastCollection;
 
+  /* non-NULL while a sliced collection of this heap is between slices */
+  struct CC_collection *collection;
+
   /** To avoid races with other processor adding to the remset (writebarrier or
     * promotions).
     */
@@ -77,6 +144,16 @@ typedef struct ConcurrentPackage *ConcurrentPackage;
 
 PRIVATE void GC_updateObjectHeader(GC_state s, pointer p, GC_header newHeader);
 
+/**
+ * Called by idle processors. If some other processor is marking a heap in a
+ * root collection that accepts helpers, help with it until it is finished.
+ */
+PRIVATE void GC_HH_helpConcurrentCollections(GC_state s);
+
+/* The number of root collections that have started but not finished,
+ * including those waiting for their next slice. */
+PRIVATE uint32_t GC_numCCsInProgress(GC_state s);
+
 #endif
 
 
@@ -98,6 +175,7 @@ void CC_collectWithRoots(
 	size_t *numObjectsMarked);
 	
 void CC_collectAtPublicLevel(GC_state s, GC_thread thread, uint32_t depth);
+struct CC_parMark *CC_newParMark(void);
 void CC_addToStack(GC_state s, ConcurrentPackage cp, pointer p);
 void CC_initStack(GC_state s, ConcurrentPackage cp);
 
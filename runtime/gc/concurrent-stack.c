@@ -15,7 +15,8 @@ void CC_stack_init(GC_state s, CC_stack* stack) {
   stack->numStacks = (size_t)s->numberOfProcs;
   // capacity = MAX(capacity, MINIMUM_CAPACITY);
 
-  stack->stacks = malloc(sizeof(struct CC_stack_data) * stack->numStacks);
+  stack->stacks =
+    allocateMetadata(s, sizeof(struct CC_stack_data) * stack->numStacks);
   for (size_t i = 0; i < stack->numStacks; i++) {
     // stack->stacks[i].size = 0;
     // stack->stacks[i].capacity = capacity;
@@ -148,7 +149,7 @@ void CC_stack_free(GC_state s, CC_stack* stack) {
   for (size_t i = 0; i < stack->numStacks; i++) {
     CC_stack_data_free(s, &(stack->stacks[i]));
   }
-  free(stack->stacks);
+  freeMetadata(s, stack->stacks, sizeof(struct CC_stack_data) * stack->numStacks);
   stack->stacks = NULL;
 }
 
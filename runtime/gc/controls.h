@@ -41,6 +41,27 @@ struct HM_HierarchicalHeapConfig {
   /* the shallowest depth that will be claimed for a local
    * collection. */
   uint32_t minLocalDepth;
+
+  /* local collections with at least this many bytes in scope are opened up
+   * to idle processors, which help trace and copy. 0 disables this. */
+  size_t minParallelCollectionSize;
+
+  /* adaptive policy: when either of these is set, the two threshold ratios
+   * above are only starting points, and are adjusted online to keep the
+   * fraction of time spent in GC near gcOverhead, and the heap under
+   * maxHeap bytes. 0 disables each. maxHeap is also a hard limit on the
+   * memory mapped by the block allocator. */
+  double gcOverhead;
+  size_t maxHeap;
+
+  /* root collections of heaps with at least this many bytes share their
+   * mark and unmark phases with idle processors. 0 disables this. */
+  size_t minParallelCCSize;
+
+  /* root collections started from the scheduler run in slices of about this
+   * many nanoseconds, returning to the scheduler in between. 0 runs each one
+   * to completion. Read atomically; may be changed at run time. */
+  uint64_t ccSliceTime;
 };
 
 enum GC_CollectionType {
@@ -65,11 +86,23 @@ struct GC_controls {
   size_t superblockThreshold; // upper bound on size-class of a superblock
   size_t megablockThreshold; // upper bound on size-class of a megablock (unmap above this threshold)
   struct timespec blockUsageSampleInterval;
+  const char *statsFile; /* where to publish live statistics, or NULL */
+  struct timespec statsExportInterval;
   float emptinessFraction;
   bool debugKeepFreeBlocks;
+  bool hugePages; /* align block mappings to huge pages, and ask for THP */
+  bool releaseEmptyBlocks; /* give back memory of empty superblocks/megablocks */
+  /* sequences without objptrs of at least this many bytes are placed in
+   * new mappings rather than reused blocks. 0 disables this. */
+  size_t freshSequenceMinSize;
+  /* a stack that outgrows its chunk moves to a fresh mapping of at least
+   * this many bytes, and then grows in place. 0 disables this. */
+  size_t stackReserve;
   bool manageEntanglement;
   bool freeListCoalesce;  /* disabled for now */
   bool setAffinity; /* whether or not to set processor affinity */
+  bool perfCounters; /* count hardware events per processor and GC phase */
+  bool followCPUQuota; /* keep the number of active processors at the cgroup CPU quota */
   int32_t affinityBase; /* First processor to use when setting affinity */
   int32_t affinityStride; /* Number of processors between first and second */
   struct GC_ratios ratios;
@@ -129,7 +129,7 @@ pointer GC_copyThread (GC_state s, pointer p) {
   assert (fromStack->reserved >= fromStack->used);
   toThread = copyThreadWithHeap (s, fromThread, fromStack->used);
   toStack = (GC_stack)(objptrToPointer(toThread->stack, NULL));
-  assert (toStack->reserved == alignStackReserved (s, toStack->used));
+  assert (toStack->reserved >= alignStackReserved (s, toStack->used));
 
   /* SPOONHOWER_NOTE: Formerly: LEAVE2 (s, "toThread", "fromThread"); */
 
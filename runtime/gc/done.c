@@ -217,7 +217,11 @@ static void displayCumulativeStatisticsJSON (FILE *out, GC_state s) {
 void GC_done(GC_state s) {
   GC_PthreadAtExit(s);
 
+  /* The other processors closed theirs as they terminated. */
+  closePerfCounters(s);
+
   if (s->controls->summary) {
+
     if (HUMAN == s->controls->summaryFormat) {
       fprintf (s->controls->summaryFile, "Global::\n");
       displayGlobalCumulativeStatistics
@@ -87,6 +87,7 @@ EBR_shared EBR_new(GC_state s, EBR_freeRetiredObj freeFun)
   ebr->local =
       malloc(s->numberOfProcs * sizeof(struct EBR_local));
   ebr->freeFun = freeFun;
+  ebr->numHolds = 0;
 
   for (uint32_t i = 0; i < s->numberOfProcs; i++)
   {
@@ -124,7 +125,8 @@ void EBR_leaveQuiescentState(GC_state s, EBR_shared ebr)
   if (UNPACK_EPOCH(otherann) == globalEpoch || UNPACK_QBIT(otherann))
   {
     uint32_t c = ++ebr->local[mypid].checkNext;
-    if (c >= numProcs)
+    if (c >= numProcs &&
+        0 == __atomic_load_n(&(ebr->numHolds), __ATOMIC_SEQ_CST))
     {
       __sync_val_compare_and_swap(&(ebr->epoch), globalEpoch, globalEpoch + 1);
     }
@@ -167,4 +169,15 @@ void EBR_retire(GC_state s, EBR_shared ebr, void *ptr)
   return;
 }
 
+void EBR_holdEpoch(EBR_shared ebr)
+{
+  __atomic_fetch_add(&(ebr->numHolds), 1, __ATOMIC_SEQ_CST);
+}
+
+void EBR_releaseEpoch(EBR_shared ebr)
+{
+  assert(ebr->numHolds > 0);
+  __atomic_fetch_sub(&(ebr->numHolds), 1, __ATOMIC_SEQ_CST);
+}
+
 #endif // MLTON_GC_INTERNAL_FUNCS
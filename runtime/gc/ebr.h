@@ -35,6 +35,9 @@ typedef struct EBR_shared
   struct EBR_local *local;
 
   EBR_freeRetiredObj freeFun;
+
+  // while nonzero, the epoch doesn't advance (see EBR_holdEpoch)
+  size_t numHolds;
 } * EBR_shared;
 
 #else
@@ -52,6 +55,13 @@ void EBR_enterQuiescentState(GC_state s, EBR_shared ebr);
 void EBR_leaveQuiescentState(GC_state s, EBR_shared ebr);
 void EBR_retire(GC_state s, EBR_shared ebr, void *ptr);
 
+/** Stop the epoch from advancing (and so, anything from being reclaimed)
+  * until the matching EBR_releaseEpoch, which may be on another processor.
+  * For references that have to outlive the caller's next quiescent state.
+  * Take the hold while not quiescent. */
+void EBR_holdEpoch(EBR_shared ebr);
+void EBR_releaseEpoch(EBR_shared ebr);
+
 #endif // MLTON_GC_INTERNAL_FUNCS
 
 #endif // EBR_H_
@@ -85,8 +85,17 @@ bool ES_mark(__attribute__((unused)) GC_state s, objptr op) {
   return mark_suspect(op);
 }
 
-void ES_unmark(GC_state s, objptr op) {
-  clear_suspect(s, &op, op, NULL);
+/* Only called right after unpinning the object, so unlike clear_suspect
+ * there is nothing to defer; just retry until the bit is gone. */
+void ES_unmark(__attribute__((unused)) GC_state s, objptr op) {
+  pointer p = objptrToPointer(op, NULL);
+  GC_header header = getHeader(p);
+  while ((1 == (header & GC_VALID_HEADER_MASK)) && suspicious_header(header)) {
+    GC_header newHeader = header & ~(SUSPECT_MASK);
+    if (__sync_bool_compare_and_swap(getHeaderp(p), header, newHeader))
+      return;
+    header = getHeader(p);
+  }
 }
 
 void ES_add(__attribute__((unused)) GC_state s, HM_chunkList es, objptr op)
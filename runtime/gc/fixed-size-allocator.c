@@ -16,6 +16,13 @@ void initFixedSizeAllocator(
   HM_initChunkList(&(fsa->buffer));
   fsa->freeList = NULL;
   fsa->sharedFreeList = NULL;
+  for (uint32_t i = 0; i < FIXED_SIZE_REMOTE_BATCHES; i++) {
+    fsa->remoteFrees[i].owner = NULL;
+    fsa->remoteFrees[i].first = NULL;
+    fsa->remoteFrees[i].last = NULL;
+    fsa->remoteFrees[i].count = 0;
+  }
+  fsa->nextRemoteEvict = 0;
 
   fsa->numAllocated = 0;
   fsa->numLocalFreed = 0;
@@ -85,12 +92,16 @@ void* allocateFixedSize(FixedSizeAllocator fsa) {
 
   /** Slow path: not enough space in the buffer, so we need to allocate a new
     * chunk. Note that this case implicitly handles the (chunk == NULL) case.
+    * This is rare, so it is also a good time to hand back the elements we
+    * are holding for other allocators.
     *
     * When we allocate a new chunk, we include a pointer (in the start gap)
     * to the containing allocator. This makes it easy to "return" freed objects
     * to their original buffer, by looking up the chunk header.
     */
 
+  flushFixedSizeRemoteFrees(fsa);
+
   chunk = HM_allocateChunkWithPurpose(buffer, fsa->fixedSize + sizeof(void*), fsa->purpose);
   pointer gap = HM_shiftChunkStart(chunk, sizeof(void*));
   *(FixedSizeAllocator *)gap = fsa;
@@ -103,6 +114,60 @@ void* allocateFixedSize(FixedSizeAllocator fsa) {
 }
 
 
+static void flushRemoteBatch(struct FixedSizeRemoteBatch *batch) {
+  FixedSizeAllocator owner = batch->owner;
+  if (0 == batch->count)
+    return;
+
+  assert(NULL != owner);
+  assert(NULL != batch->first && NULL != batch->last);
+  while (true) {
+    struct FixedSizeElement *oldVal = owner->sharedFreeList;
+    batch->last->nextFree = oldVal;
+    if (__sync_bool_compare_and_swap(&(owner->sharedFreeList), oldVal, batch->first))
+      break;
+  }
+  __sync_fetch_and_add(&(owner->numSharedFreed), batch->count);
+
+  batch->owner = NULL;
+  batch->first = NULL;
+  batch->last = NULL;
+  batch->count = 0;
+}
+
+
+void flushFixedSizeRemoteFrees(FixedSizeAllocator myfsa) {
+  for (uint32_t i = 0; i < FIXED_SIZE_REMOTE_BATCHES; i++)
+    flushRemoteBatch(&(myfsa->remoteFrees[i]));
+}
+
+
+static struct FixedSizeRemoteBatch* remoteBatchFor(
+  FixedSizeAllocator myfsa,
+  FixedSizeAllocator owner)
+{
+  struct FixedSizeRemoteBatch *empty = NULL;
+  for (uint32_t i = 0; i < FIXED_SIZE_REMOTE_BATCHES; i++) {
+    struct FixedSizeRemoteBatch *batch = &(myfsa->remoteFrees[i]);
+    if (batch->owner == owner)
+      return batch;
+    if (NULL == empty && 0 == batch->count)
+      empty = batch;
+  }
+
+  if (NULL == empty) {
+    /* all batches are in use for other owners; return one of them early */
+    empty = &(myfsa->remoteFrees[myfsa->nextRemoteEvict]);
+    myfsa->nextRemoteEvict =
+      (myfsa->nextRemoteEvict + 1) % FIXED_SIZE_REMOTE_BATCHES;
+    flushRemoteBatch(empty);
+  }
+
+  empty->owner = owner;
+  return empty;
+}
+
+
 void freeFixedSize(FixedSizeAllocator myfsa, void* arg) {
   HM_chunk chunk = HM_getChunkOf((pointer)arg);
   pointer gap = HM_getChunkStartGap(chunk);
@@ -122,15 +187,18 @@ void freeFixedSize(FixedSizeAllocator myfsa, void* arg) {
     return;
   }
 
-  /** Slow path: concurrent insertion into other shared freelist.
+  /** Slow path: hold onto the element until we have a batch for its owner,
+    * and then insert the whole batch into the owner's shared freelist.
     */
-  while (true) {
-    struct FixedSizeElement *oldVal = owner->sharedFreeList;
-    elem->nextFree = oldVal;
-    if (__sync_bool_compare_and_swap(&(owner->sharedFreeList), oldVal, elem))
-      break;
-  }
-  __sync_fetch_and_add(&(owner->numSharedFreed), (size_t)1);
+  struct FixedSizeRemoteBatch *batch = remoteBatchFor(myfsa, owner);
+  elem->nextFree = batch->first;
+  batch->first = elem;
+  if (NULL == batch->last)
+    batch->last = elem;
+  batch->count++;
+
+  if (batch->count >= FIXED_SIZE_REMOTE_BATCH_SIZE)
+    flushRemoteBatch(batch);
 }
 
 
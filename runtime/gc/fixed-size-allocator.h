@@ -13,6 +13,22 @@ struct FixedSizeElement {
   struct FixedSizeElement *nextFree;
 };
 
+/** Frees of elements owned by some other allocator are collected into a
+  * small number of batches, one per owner, and each batch is spliced onto
+  * the owner's shared free-list with a single CAS. So a processor that frees
+  * many remote objects (e.g. at a join, or when reclaiming retired heaps)
+  * contends on the owner's list once per batch instead of once per object.
+  */
+#define FIXED_SIZE_REMOTE_BATCHES 4
+#define FIXED_SIZE_REMOTE_BATCH_SIZE 32
+
+struct FixedSizeRemoteBatch {
+  struct FixedSizeAllocator *owner;
+  struct FixedSizeElement *first;
+  struct FixedSizeElement *last;
+  size_t count;
+};
+
 typedef struct FixedSizeAllocator {
   /** The size of each element.
     * Must be >= sizeof(struct FixedSizeElement), because when an object is
@@ -44,14 +60,19 @@ typedef struct FixedSizeAllocator {
 
   /** The slow free-list, which is safe-for-concurrency. (When someone else
     * owns an object, we have to use this list, because the
-    * owner's allocator could concurrently be in use.)
-    *
-    * TODO: flat-combining for these frees? I.e. use a bump-buffer of elements
-    * returned, and then when a new allocation request comes in, move all of
-    * these elements to the fast free list.
+    * owner's allocator could concurrently be in use.) Other allocators push
+    * whole batches onto it, see remoteFrees; the owner takes the entire list
+    * at once when its fast free-list runs dry.
     */
   struct FixedSizeElement *sharedFreeList;
 
+  /** Elements this allocator has freed on behalf of others, not yet
+    * returned to their owners. Only touched by the processor that owns this
+    * allocator.
+    */
+  struct FixedSizeRemoteBatch remoteFrees[FIXED_SIZE_REMOTE_BATCHES];
+  uint32_t nextRemoteEvict;
+
 } *FixedSizeAllocator;
 
 #else
@@ -97,6 +118,14 @@ void* allocateFixedSize(FixedSizeAllocator fsa);
 void freeFixedSize(FixedSizeAllocator myfsa, void* elem);
 
 
+/** Return all elements that [myfsa] has freed on behalf of other allocators
+  * to their owners. Freeing does this automatically whenever a batch fills
+  * up, so this is only needed to bound how long a freed element can stay
+  * unavailable to its owner.
+  */
+void flushFixedSizeRemoteFrees(FixedSizeAllocator myfsa);
+
+
 size_t numFixedSizeAllocated(FixedSizeAllocator fsa);
 size_t numFixedSizeFreed(FixedSizeAllocator fsa);
 size_t numFixedSizeSharedFreed(FixedSizeAllocator fsa);
@@ -37,9 +37,10 @@ void growStackCurrent(GC_state s) {
   assert(HM_getChunkFrontier(chunk) == HM_getChunkStart(chunk) +
     sizeofStackWithMetaData(s, getStackCurrent(s)->reserved));
 
-  /* the easy case: plenty of space in the stack's chunk to just grow the
-   * stack in place. */
-  if (stackSize <= (size_t)(HM_getChunkLimit(chunk) - HM_getChunkStart(chunk))) {
+  /* the easy case: plenty of space in the stack's chunk (or in its reserve)
+   * to just grow the stack in place. */
+  if (stackSize <= (size_t)(HM_getChunkLimit(chunk) - HM_getChunkStart(chunk))
+      || HM_growReservedChunk(s, HM_HH_getChunkList(hh), chunk, stackSize)) {
     getStackCurrent(s)->reserved = reserved;
     HM_updateChunkFrontierInList(
       HM_HH_getChunkList(hh),
@@ -52,16 +53,28 @@ void growStackCurrent(GC_state s) {
     HM_HH_getHeapAtDepth(s, getThreadCurrent(s), HM_HH_getDepth(hh));
 
   /* in this case, the new stack needs more space, so allocate a new chunk,
-   * copy the stack, and throw away the old chunk. */
-  HM_chunk newChunk = HM_allocateChunkWithPurpose(
-    HM_HH_getChunkList(newhh),
-    stackSize,
-    BLOCK_FOR_HEAP_CHUNK);
-    
+   * copy the stack, and throw away the old chunk. With a stack reserve, the
+   * new chunk is a fresh mapping big enough that later growth happens in
+   * place; its pages are only committed as the stack reaches them, and only
+   * those the stack uses count as part of the heap. */
+  HM_chunk newChunk;
+  if (stackSize < s->controls->stackReserve) {
+    newChunk = HM_allocateFreshChunk(
+      HM_HH_getChunkList(newhh),
+      s->controls->stackReserve);
+  } else {
+    newChunk = HM_allocateChunkWithPurpose(
+      HM_HH_getChunkList(newhh),
+      stackSize,
+      BLOCK_FOR_HEAP_CHUNK);
+  }
+
   if (NULL == newChunk) {
     DIE("Ran out of space to grow stack!");
   }
-  assert(stackSize < HM_getChunkSizePastFrontier(newChunk));
+  if (stackSize < s->controls->stackReserve)
+    HM_reserveChunkTail(s, HM_HH_getChunkList(newhh), newChunk, stackSize);
+  assert(stackSize <= HM_getChunkSizePastFrontier(newChunk));
   newChunk->mightContainMultipleObjects = FALSE;
   newChunk->levelHead = HM_HH_getUFNode(newhh);
   newChunk->decheckState = chunk->decheckState;
@@ -107,6 +120,8 @@ void GC_collect (GC_state s, size_t bytesRequested, bool force) {
   // HM_EBR_enterQuiescentState(s);
 
   maybeSample(s, s->blockUsageSampler);
+  if (NULL != s->statsExportSampler)
+    maybeSample(s, s->statsExportSampler);
 
   // HM_HierarchicalHeap h = getThreadCurrent(s)->hierarchicalHeap;
   // while (h->nextAncestor != NULL) h = h->nextAncestor;
@@ -58,6 +58,10 @@ struct FixedSizeAllocator* getUFAllocator(GC_state s) {
   return &(s->hhUnionFindAllocator);
 }
 
+struct SizeClassAllocator* getMetadataAllocator(GC_state s) {
+  return &(s->metadataAllocator);
+}
+
 Bool_t GC_getAmOriginal (GC_state s) {
   return (Bool_t)(s->amOriginal);
 }
@@ -81,6 +85,18 @@ uint32_t GC_getControlMaxCCDepth(GC_state s) {
   return (uint32_t)s->controls->hhConfig.maxCCDepth;
 }
 
+uint64_t GC_getControlCCSliceTime(GC_state s) {
+  return __atomic_load_n(&(s->controls->hhConfig.ccSliceTime), __ATOMIC_RELAXED);
+}
+
+void GC_setControlCCSliceTime(GC_state s, uint64_t nanoseconds) {
+  __atomic_store_n(&(s->controls->hhConfig.ccSliceTime), nanoseconds, __ATOMIC_RELAXED);
+}
+
+uintmax_t GC_getControlMaxHeap(GC_state s) {
+  return (uintmax_t)s->controls->hhConfig.maxHeap;
+}
+
 // SAM_NOTE: TODO: remove this and replace with blocks statistics
 size_t GC_getMaxChunkPoolOccupancy (void) {
   return 0;
@@ -185,6 +201,10 @@ uintmax_t GC_getNumCCsOfProc(GC_state s, uint32_t proc) {
   return s->procStates[proc].cumulativeStatistics->numCCs;
 }
 
+uintmax_t GC_getNumCCSlicesOfProc(GC_state s, uint32_t proc) {
+  return s->procStates[proc].cumulativeStatistics->numCCSlices;
+}
+
 uintmax_t GC_getCCMillisecondsOfProc(GC_state s, uint32_t proc) {
   struct timespec *t = &(s->procStates[proc].cumulativeStatistics->timeCC);
   return (uintmax_t)t->tv_sec * 1000 + (uintmax_t)t->tv_nsec / 1000000;
@@ -204,6 +224,17 @@ uintmax_t GC_getPromoMillisecondsOfProc(GC_state s, uint32_t proc) {
   return (uintmax_t)t->tv_sec * 1000 + (uintmax_t)t->tv_nsec / 1000000;
 }
 
+uintmax_t GC_getJoinMillisecondsOfProc(GC_state s, uint32_t proc) {
+  struct GC_cumulativeStatistics *cs = s->procStates[proc].cumulativeStatistics;
+  struct timespec t = cs->timeJoinMerge;
+  timespec_add(&t, &(cs->timeJoinPromote));
+  return (uintmax_t)t.tv_sec * 1000 + (uintmax_t)t.tv_nsec / 1000000;
+}
+
+uintmax_t GC_getNumJoinsOfProc(GC_state s, uint32_t proc) {
+  return s->procStates[proc].cumulativeStatistics->numJoinMerges;
+}
+
 uintmax_t GC_numDisentanglementChecks(GC_state s) {
   uintmax_t count = 0;
   for (uint32_t p = 0; p < s->numberOfProcs; p++) {
@@ -25,6 +25,8 @@ struct GC_state {
   /* Alphabetized fields follow. */
   size_t alignment; /* */
   volatile bool amInGC;
+  /* ~(blockSize-1); lets generated code find the chunk of an object. */
+  size_t blockMask;
   struct HM_HierarchicalHeap *currentCCTargetHH;
   bool amOriginal;
   char **atMLtons; /* Initial @MLton args, processed before command line. */
@@ -33,6 +35,8 @@ struct GC_state {
   struct BlockAllocator *blockAllocatorGlobal;
   struct BlockAllocator *blockAllocatorLocal;
   struct Sampler *blockUsageSampler;
+  struct Sampler *statsExportSampler; /* NULL unless gc-stats-file is given */
+  struct PerfCounters perfCounters;
   objptr callFromCHandlerThread; /* Handler for exported C calls (in heap). */
   pointer callFromCOpArgsResPtr; /* Pass op, args, and res from exported C call */
   struct GC_controls *controls;
@@ -52,9 +56,17 @@ struct GC_state {
   uint32_t globalsLength;
   struct FixedSizeAllocator hhAllocator;
   struct FixedSizeAllocator hhUnionFindAllocator;
+  struct SizeClassAllocator metadataAllocator;
   struct EBR_shared * hhEBR;
   struct EBR_shared * hmEBR;
   struct GC_lastMajorStatistics *lastMajorStatistics;
+  /* Shared with idle processors that help with this processor's local
+   * collections. Allocated once; never freed. */
+  struct HM_HHC_parWork *lgcParWork;
+  /* Likewise, for the mark phases of this processor's root collections. */
+  struct CC_parMark *ccParMark;
+  struct HM_HH_adaptivePolicy *adaptivePolicy;
+  struct HM_HH_rememberBuffer *rememberBuffer;
   pointer limitPlusSlop; /* limit + GC_HEAP_LIMIT_SLOP */
   int (*loadGlobals)(FILE *f); /* loads the globals from the file. */
   uint32_t magic; /* The magic number for this executable. */
@@ -91,6 +103,13 @@ struct GC_state {
   char *worldFile;
   struct TracingContext *trace;
   struct TLSObjects tlsObjects;
+  /* The union-find node of a heap that is known to be a level head and
+   * unregistered for CC, or NULL. Generated code skips the write barrier
+   * call when dst, src and the old field value all live in chunks that point
+   * directly at this node. Only the write barrier sets it, and it is reset
+   * whenever heaps are merged, promoted, collected, registered for CC, or the
+   * processor switches threads. */
+  struct HM_UnionFindNode *writeBarrierLevelHead;
 };
 
 #endif /* (defined (MLTON_GC_INTERNAL_TYPES)) */
@@ -103,6 +122,7 @@ static inline size_t sizeofGCStateCurrentStackUsed (GC_state s);
 static inline void setGCStateCurrentThreadAndStack (GC_state s);
 
 static inline struct FixedSizeAllocator* getHHAllocator(GC_state s);
+static inline struct SizeClassAllocator* getMetadataAllocator(GC_state s);
 
 
 #endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
@@ -130,10 +150,13 @@ PRIVATE uintmax_t GC_getCumulativeStatisticsBytesAllocatedOfProc(GC_state s, uin
 PRIVATE uintmax_t GC_getCumulativeStatisticsLocalBytesReclaimedOfProc(GC_state s, uint32_t proc);
 PRIVATE uintmax_t GC_getLocalGCMillisecondsOfProc(GC_state s, uint32_t proc);
 PRIVATE uintmax_t GC_getPromoMillisecondsOfProc(GC_state s, uint32_t proc);
+PRIVATE uintmax_t GC_getJoinMillisecondsOfProc(GC_state s, uint32_t proc);
+PRIVATE uintmax_t GC_getNumJoinsOfProc(GC_state s, uint32_t proc);
 
 PRIVATE uintmax_t GC_getCumulativeStatisticsNumLocalGCsOfProc(GC_state s, uint32_t proc);
 
 PRIVATE uintmax_t GC_getNumCCsOfProc(GC_state s, uint32_t proc);
+PRIVATE uintmax_t GC_getNumCCSlicesOfProc(GC_state s, uint32_t proc);
 PRIVATE uintmax_t GC_getCCMillisecondsOfProc(GC_state s, uint32_t proc);
 PRIVATE uintmax_t GC_getCCBytesReclaimedOfProc(GC_state s, uint32_t proc);
 PRIVATE uintmax_t GC_bytesInScopeForLocal(GC_state s);
@@ -149,6 +172,9 @@ PRIVATE uintmax_t GC_bytesPinnedEntangledWatermark(GC_state s);
 PRIVATE void GC_updateBytesPinnedEntangledWatermark(GC_state s);
 
 PRIVATE uint32_t GC_getControlMaxCCDepth(GC_state s);
+PRIVATE uint64_t GC_getControlCCSliceTime(GC_state s);
+PRIVATE void GC_setControlCCSliceTime(GC_state s, uint64_t nanoseconds);
+PRIVATE uintmax_t GC_getControlMaxHeap(GC_state s);
 
 PRIVATE pointer GC_getCallFromCHandlerThread (GC_state s);
 PRIVATE void GC_setCallFromCHandlerThreads (GC_state s, pointer p);
@@ -100,6 +100,16 @@ pointer copyObject(pointer p,
 
 void delLastObj(objptr op, size_t objectSize, HM_HierarchicalHeap tgtHeap);
 
+void forwardHHObjptrParallel(
+    GC_state s,
+    objptr *opp,
+    objptr op,
+    struct ForwardHHObjptrArgs *args);
+
+void compressFromSpaceLevelHeads(struct ForwardHHObjptrArgs *args);
+void parallelScanField(GC_state s, objptr *field, void *rawArgs);
+HM_HierarchicalHeap scanInParallel(GC_state s, struct ForwardHHObjptrArgs *args);
+
 /**
  * ObjptrPredicateFunction for skipping stacks and threads in the hierarchical
  * heap.
@@ -116,10 +126,103 @@ bool skipStackAndThreadObjptrPredicate(GC_state s,
                                        pointer p,
                                        void *rawArgs);
 
+/* The number of local collections currently open to helpers. Idle
+ * processors call GC_HH_helpLocalCollections after every failed steal, so
+ * this lets them skip looking at every processor when there is nothing to
+ * join, which is almost always. */
+static volatile uint32_t numOpenParWork = 0;
+
 /************************/
 /* Function Definitions */
 /************************/
 #if (defined(MLTON_GC_INTERNAL_BASIS))
+
+void GC_HH_helpLocalCollections(GC_state s)
+{
+  if (0 == s->controls->hhConfig.minParallelCollectionSize ||
+      NULL == s->procStates ||
+      !WT_anyOpen(&numOpenParWork))
+  {
+    return;
+  }
+
+  for (uint32_t i = 1; i < s->numberOfProcs; i++)
+  {
+    GC_state owner = &(s->procStates[(s->procNumber + i) % s->numberOfProcs]);
+    struct HM_HHC_parWork *w = owner->lgcParWork;
+
+    if (!WT_tryJoin(&(w->team)))
+    {
+      continue;
+    }
+    struct ForwardHHObjptrArgs *ownerArgs = w->ownerArgs;
+
+    HM_HierarchicalHeap toSpace[ownerArgs->maxDepth + 1];
+    for (uint32_t d = 0; d <= ownerArgs->maxDepth; d++)
+      toSpace[d] = NULL;
+
+    struct ForwardHHObjptrArgs args =
+        {.hh = ownerArgs->hh,
+         .minDepth = ownerArgs->minDepth,
+         .maxDepth = ownerArgs->maxDepth,
+         .toDepth = HM_HH_INVALID_DEPTH,
+         .fromSpace = ownerArgs->fromSpace,
+         .toSpace = &(toSpace[0]),
+         .toSpaceStart = NULL,
+         .toSpaceStartChunk = NULL,
+         .pinned = ownerArgs->pinned,
+         .containingObject = BOGUS_OBJPTR,
+         .bytesCopied = 0,
+         .entangledBytes = 0,
+         .objectsCopied = 0,
+         .stacksCopied = 0,
+         .bytesMoved = 0,
+         .objectsMoved = 0,
+         .concurrent = false,
+         .parWork = w};
+    CC_workList_init(s, &(args.worklist));
+
+    struct PerfCounterSample perfStart;
+    bool perfSampling = beginPerfCounterPhase(s, &perfStart);
+    WT_drain(s, &(w->team), &(args.worklist), parallelScanField, &args);
+    if (perfSampling)
+      endPerfCounterPhase(s, PERF_PHASE_LOCAL_GC, &perfStart);
+
+    CC_workList_free(s, &(args.worklist));
+
+    /* hand the copied objects over to the owner */
+    HM_HierarchicalHeap chain = NULL;
+    for (uint32_t d = 0; d <= args.maxDepth; d++)
+    {
+      if (NULL == toSpace[d])
+        continue;
+      toSpace[d]->nextAncestor = chain;
+      chain = toSpace[d];
+    }
+
+    pthread_mutex_lock(&(w->team.lock));
+    if (NULL != chain)
+    {
+      w->helperToSpace = HM_HH_zip(s, w->helperToSpace, chain);
+    }
+    w->bytesCopied += args.bytesCopied;
+    w->objectsCopied += args.objectsCopied;
+    w->stacksCopied += args.stacksCopied;
+    w->bytesMoved += args.bytesMoved;
+    w->objectsMoved += args.objectsMoved;
+    pthread_mutex_unlock(&(w->team.lock));
+
+    WT_leave(&(w->team));
+
+    LOG(LM_HH_COLLECTION, LL_INFO,
+        "helped local collection of proc %u: copied %" PRIu64 " objects, moved %" PRIu64,
+        owner->procNumber,
+        args.objectsCopied,
+        args.objectsMoved);
+    return;
+  }
+}
+
 #endif /* MLTON_GC_INTERNAL_BASIS */
 
 #if (defined(MLTON_GC_INTERNAL_FUNCS))
@@ -198,6 +301,9 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
   struct timespec stopTime;
   uint64_t oldObjectCopied;
 
+  HM_HH_flushRememberBuffer(s);
+  s->writeBarrierLevelHead = NULL;
+
   if (NONE == s->controls->collectionType)
   {
     /* collection disabled */
@@ -314,7 +420,8 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
       .stacksCopied = 0,
       .bytesMoved = 0,
       .objectsMoved = 0,
-      .concurrent = false};
+      .concurrent = false,
+      .parWork = NULL};
   CC_workList_init(s, &(forwardHHObjptrArgs.worklist));
   struct GC_foreachObjptrClosure forwardHHObjptrClosure =
       {.fun = forwardHHObjptr, .env = &forwardHHObjptrArgs};
@@ -448,6 +555,8 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
    * events are hardcoded, ugh. */
   Trace0(EVENT_PROMOTION_ENTER);
   timespec_now(&startTime);
+  struct PerfCounterSample perfStart;
+  bool perfSampling = beginPerfCounterPhase(s, &perfStart);
 
   forwardHHObjptrArgs.concurrent = true;
   /* For each remembered entry, if possible, unpin and discard the entry.
@@ -493,6 +602,8 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
   timespec_now(&stopTime);
   timespec_sub(&stopTime, &startTime);
   timespec_add(&(s->cumulativeStatistics->timeLocalPromo), &stopTime);
+  if (perfSampling)
+    endPerfCounterPhase(s, PERF_PHASE_PROMOTION, &perfStart);
   Trace0(EVENT_PROMOTION_LEAVE);
 
   /* ===================================================================== */
@@ -503,6 +614,7 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
   }
 
   timespec_now(&startTime);
+  perfSampling = beginPerfCounterPhase(s, &perfStart);
 
   LOG(LM_HH_COLLECTION, LL_DEBUG, "START root copy");
 
@@ -511,6 +623,16 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
   // forwardHHObjptrArgs.toSpace = &(toSpace[0]);
   forwardHHObjptrArgs.toDepth = HM_HH_INVALID_DEPTH;
 
+  if (0 != s->controls->hhConfig.minParallelCollectionSize &&
+      totalSizeBefore >= s->controls->hhConfig.minParallelCollectionSize &&
+      s->numberOfProcs > 1)
+  {
+    /* Share the tracing with idle processors. From here on, copied objects
+     * are pushed on the worklist instead of being Cheney-scanned. */
+    compressFromSpaceLevelHeads(&forwardHHObjptrArgs);
+    forwardHHObjptrArgs.parWork = s->lgcParWork;
+  }
+
   /* forward contents of stack */
   oldObjectCopied = forwardHHObjptrArgs.objectsCopied;
   foreachObjptrInObject(s,
@@ -590,42 +712,67 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
 
   /* off-by-one to prevent underflow */
   uint32_t depth = thread->currentDepth + 1;
-  while (depth > forwardHHObjptrArgs.minDepth)
+  HM_HierarchicalHeap helperToSpace = NULL;
+  if (NULL != forwardHHObjptrArgs.parWork)
   {
-    depth--;
-    HM_HierarchicalHeap toSpaceLevel = toSpace[depth];
-    if (NULL == toSpaceLevel)
+    /* forward the from-elements of the down-ptrs. These (and everything
+     * copied so far) are on the worklist, and traced in parallel below. */
+    while (depth > forwardHHObjptrArgs.minDepth)
     {
-      continue;
+      depth--;
+      HM_HierarchicalHeap toSpaceLevel = toSpace[depth];
+      if (NULL == toSpaceLevel)
+      {
+        continue;
+      }
+
+      struct HM_foreachDownptrClosure closure =
+          {.fun = forwardFromObjsOfRemembered, .env = (void *)&forwardHHObjptrArgs};
+      HM_foreachPrivate(s, &(HM_HH_getRemSet(toSpaceLevel)->private), &closure);
     }
 
-    LOG(LM_HH_COLLECTION, LL_INFO,
-        "level %" PRIu32 ": num pinned: %zu",
-        depth,
-        HM_numRemembered(HM_HH_getRemSet(toSpaceLevel)));
+    helperToSpace = scanInParallel(s, &forwardHHObjptrArgs);
+    forwardHHObjptrArgs.parWork = NULL;
+  }
+  else
+  {
+    while (depth > forwardHHObjptrArgs.minDepth)
+    {
+      depth--;
+      HM_HierarchicalHeap toSpaceLevel = toSpace[depth];
+      if (NULL == toSpaceLevel)
+      {
+        continue;
+      }
 
-    /* forward the from-elements of the down-ptrs */
-    struct HM_foreachDownptrClosure closure =
-        {.fun = forwardFromObjsOfRemembered, .env = (void *)&forwardHHObjptrArgs};
-    // HM_foreachRemembered pops the public remSet into private. So it interferes
-    // with the unmarking phase of GC. So use HM_foreachPrivate instead.
-    HM_foreachPrivate(s, &(HM_HH_getRemSet(toSpaceLevel)->private), &closure);
+      LOG(LM_HH_COLLECTION, LL_INFO,
+          "level %" PRIu32 ": num pinned: %zu",
+          depth,
+          HM_numRemembered(HM_HH_getRemSet(toSpaceLevel)));
 
-    if (NULL != HM_HH_getChunkList(toSpaceLevel)->firstChunk)
-    {
-      HM_chunkList toSpaceList = HM_HH_getChunkList(toSpaceLevel);
-      pointer start = toSpaceStart[depth] != NULL ? toSpaceStart[depth] : HM_getChunkStart(toSpaceList->firstChunk);
-      HM_chunk startChunk = toSpaceStartChunk[depth] != NULL ? toSpaceStartChunk[depth] : toSpaceList->firstChunk;
-      HM_forwardHHObjptrsInChunkList(
-          s,
-          startChunk,
-          start,
-          // &skipStackAndThreadObjptrPredicate,
-          // &ssatoPredicateArgs,
-          &trueObjptrPredicate,
-          NULL,
-          &forwardHHObjptr,
-          &forwardHHObjptrArgs);
+      /* forward the from-elements of the down-ptrs */
+      struct HM_foreachDownptrClosure closure =
+          {.fun = forwardFromObjsOfRemembered, .env = (void *)&forwardHHObjptrArgs};
+      // HM_foreachRemembered pops the public remSet into private. So it interferes
+      // with the unmarking phase of GC. So use HM_foreachPrivate instead.
+      HM_foreachPrivate(s, &(HM_HH_getRemSet(toSpaceLevel)->private), &closure);
+
+      if (NULL != HM_HH_getChunkList(toSpaceLevel)->firstChunk)
+      {
+        HM_chunkList toSpaceList = HM_HH_getChunkList(toSpaceLevel);
+        pointer start = toSpaceStart[depth] != NULL ? toSpaceStart[depth] : HM_getChunkStart(toSpaceList->firstChunk);
+        HM_chunk startChunk = toSpaceStartChunk[depth] != NULL ? toSpaceStartChunk[depth] : toSpaceList->firstChunk;
+        HM_forwardHHObjptrsInChunkList(
+            s,
+            startChunk,
+            start,
+            // &skipStackAndThreadObjptrPredicate,
+            // &ssatoPredicateArgs,
+            &trueObjptrPredicate,
+            NULL,
+            &forwardHHObjptr,
+            &forwardHHObjptrArgs);
+      }
     }
   }
 
@@ -794,6 +941,12 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
     hhToSpace = toSpace[i];
   }
 
+  /* merge in whatever the helpers copied */
+  if (NULL != helperToSpace)
+  {
+    hhToSpace = HM_HH_zip(s, hhToSpace, helperToSpace);
+  }
+
   /* merge in toSpace */
   if (NULL == hh && NULL == hhToSpace)
   {
@@ -974,6 +1127,9 @@ void HM_HHC_collectLocal(uint32_t desiredScope)
   timespec_now(&stopTime);
   timespec_sub(&stopTime, &startTime);
   timespec_add(&(s->cumulativeStatistics->timeLocalGC), &stopTime);
+  if (perfSampling)
+    endPerfCounterPhase(s, PERF_PHASE_LOCAL_GC, &perfStart);
+  HM_HH_updateAdaptivePolicy(s);
 
   // if (stopTime.tv_sec >= 1 || stopTime.tv_nsec > 999999999 / 2) {
   //   printf("[WARN] long GC %lld.%.9ld s, %d -> %d, %d\n",
@@ -1763,6 +1919,12 @@ void forwardHHObjptr(
     return;
   }
 
+  if (NULL != args->parWork)
+  {
+    forwardHHObjptrParallel(s, opp, op, args);
+    return;
+  }
+
   uint32_t opDepth = HM_getObjptrDepthPathCompress(op);
 
   // if (opDepth > args->maxDepth)
@@ -1857,32 +2019,38 @@ void forwardHHObjptr(
     assert(HM_getObjptrDepth(op) >= args->minDepth);
     assert(HM_getObjptrDepth(op) == opDepth);
     assert(opDepth >= args->minDepth);
-    /* forward the object */
-    GC_objectTypeTag tag;
-    size_t metaDataBytes;
-    size_t objectBytes;
-    size_t copyBytes;
 
-    /* compute object size and bytes to be copied */
-    tag = computeObjectCopyParameters(s,
-                                      getHeader(p),
-                                      p,
-                                      &objectBytes,
-                                      &copyBytes,
-                                      &metaDataBytes);
-
-    switch (tag)
+    /* A sequence without objptrs in a chunk of its own: it is not a stack
+     * and is moved with its chunk, so skip straight to relocating it. */
+    if (!HM_getChunkOf(p)->noObjptrs)
     {
-    case STACK_TAG:
-      args->stacksCopied++;
-      break;
-    case WEAK_TAG:
-      die(__FILE__ ":%d: "
-                   "forwardHHObjptr() does not support WEAK_TAG objects!",
-          __LINE__);
-      break;
-    default:
-      break;
+      /* forward the object */
+      GC_objectTypeTag tag;
+      size_t metaDataBytes;
+      size_t objectBytes;
+      size_t copyBytes;
+
+      /* compute object size and bytes to be copied */
+      tag = computeObjectCopyParameters(s,
+                                        getHeader(p),
+                                        p,
+                                        &objectBytes,
+                                        &copyBytes,
+                                        &metaDataBytes);
+
+      switch (tag)
+      {
+      case STACK_TAG:
+        args->stacksCopied++;
+        break;
+      case WEAK_TAG:
+        die(__FILE__ ":%d: "
+                     "forwardHHObjptr() does not support WEAK_TAG objects!",
+            __LINE__);
+        break;
+      default:
+        break;
+      }
     }
 
     HM_HierarchicalHeap tgtHeap = toSpaceHH(s, args, opDepth);
@@ -1901,6 +2069,227 @@ void forwardHHObjptr(
       *opp);
 }
 
+/* ========================================================================= */
+
+/* Number of worklist pops between checks for idle workers, and how many
+ * elements to hand off at a time. */
+#define LGC_PAR_SHARE_PERIOD 256
+#define LGC_PAR_SHARE_BATCH 32
+
+struct HM_HHC_parWork *HM_HHC_newParWork(void)
+{
+  struct HM_HHC_parWork *w = malloc_safe(sizeof(struct HM_HHC_parWork));
+  WT_init(&(w->team), LGC_PAR_SHARE_PERIOD, LGC_PAR_SHARE_BATCH, &numOpenParWork);
+  w->ownerArgs = NULL;
+  w->helperToSpace = NULL;
+  w->bytesCopied = 0;
+  w->objectsCopied = 0;
+  w->stacksCopied = 0;
+  w->bytesMoved = 0;
+  w->objectsMoved = 0;
+  return w;
+}
+
+/* Helpers look up the levelHead of every in-scope chunk they come across, so
+ * make sure these are all one hop away before the helpers arrive. */
+void compressFromSpaceLevelHeads(struct ForwardHHObjptrArgs *args)
+{
+  for (uint32_t depth = args->minDepth; depth <= args->maxDepth; depth++)
+  {
+    if (NULL == args->fromSpace[depth])
+      continue;
+
+    HM_chunkList lists[2] =
+        {HM_HH_getChunkList(args->fromSpace[depth]), &(args->pinned[depth])};
+    for (int i = 0; i < 2; i++)
+    {
+      for (HM_chunk chunk = lists[i]->firstChunk;
+           NULL != chunk;
+           chunk = chunk->nextChunk)
+      {
+        HM_getLevelHeadPathCompress(chunk);
+      }
+    }
+  }
+}
+
+/* The same as forwardHHObjptr, except that other processors might be
+ * forwarding the same object at the same time. Unpinning goes through
+ * disentangleObject, as in the serial case; installing the forwarding pointer
+ * is a CAS on a snapshot of the (unpinned) header, and moving whole chunks is
+ * done under the lock. We never
+ * path-compress here, because that could undo a concurrent chunk move.
+ */
+void forwardHHObjptrParallel(
+    GC_state s,
+    objptr *opp,
+    objptr op,
+    struct ForwardHHObjptrArgs *args)
+{
+  struct HM_HHC_parWork *w = args->parWork;
+  pointer p = objptrToPointer(op, NULL);
+  HM_chunk chunk = HM_getChunkOf(p);
+  HM_HierarchicalHeap levelHead = HM_getLevelHead(chunk);
+  uint32_t opDepth = HM_HH_getDepth(levelHead);
+
+  if (opDepth > args->maxDepth || opDepth < args->minDepth ||
+      levelHead != args->fromSpace[opDepth])
+  {
+    /* out of scope, or already in some toSpace */
+    return;
+  }
+
+  GC_header header = getHeader(p);
+  while (TRUE)
+  {
+    if (isFwdHeader(header))
+    {
+      *opp = getFwdPtr(p);
+      return;
+    }
+
+    if (MARK_MASK & header)
+    {
+      /* collected in-place */
+      return;
+    }
+
+    if (pinType(header) == PIN_NONE)
+      break;
+
+    if (unpinDepthOfH(header) < opDepth)
+    {
+      /* truly pinned */
+      return;
+    }
+
+    /* lazily unpin; see forwardHHObjptr. This only touches the pin and
+     * suspect bits, so whether we or another helper won, look again. */
+    disentangleObject(s, op, opDepth);
+    header = getHeader(p);
+  }
+
+  size_t metaDataBytes;
+  size_t objectBytes;
+  size_t copyBytes;
+  GC_objectTypeTag tag = computeObjectCopyParameters(s,
+                                                     header,
+                                                     p,
+                                                     &objectBytes,
+                                                     &copyBytes,
+                                                     &metaDataBytes);
+  if (WEAK_TAG == tag)
+  {
+    die(__FILE__ ":%d: "
+                 "forwardHHObjptr() does not support WEAK_TAG objects!",
+        __LINE__);
+  }
+
+  HM_HierarchicalHeap tgtHeap = toSpaceHH(s, args, opDepth);
+
+  if (!chunk->mightContainMultipleObjects)
+  {
+    bool moved = FALSE;
+    pthread_mutex_lock(&(w->team.lock));
+    if (HM_getLevelHead(chunk) == levelHead)
+    {
+      HM_unlinkChunkPreserveLevelHead(HM_HH_getChunkList(levelHead), chunk);
+      HM_appendChunk(HM_HH_getChunkList(tgtHeap), chunk);
+      chunk->levelHead = HM_HH_getUFNode(tgtHeap);
+      moved = TRUE;
+    }
+    pthread_mutex_unlock(&(w->team.lock));
+
+    if (moved)
+    {
+      args->bytesMoved += copyBytes;
+      args->objectsMoved++;
+      if (!chunk->noObjptrs)
+        CC_workList_push(s, &(args->worklist), op);
+    }
+    return;
+  }
+
+  while (TRUE)
+  {
+    pointer copyPointer = copyObject(p - metaDataBytes,
+                                     objectBytes,
+                                     copyBytes,
+                                     tgtHeap);
+    objptr newPointer = pointerToObjptr(copyPointer + metaDataBytes, NULL);
+
+    if (__sync_bool_compare_and_swap(getFwdPtrp(p), header, newPointer))
+    {
+      args->bytesCopied += copyBytes;
+      args->objectsCopied++;
+      if (STACK_TAG == tag)
+        args->stacksCopied++;
+      CC_workList_push(s, &(args->worklist), newPointer);
+      *opp = newPointer;
+      return;
+    }
+
+    /* Lost a race. Either someone else forwarded it, or the header changed
+     * underneath us; in both cases, discard our copy and look again. */
+    delLastObj(newPointer, objectBytes, tgtHeap);
+    header = getHeader(p);
+    if (isFwdHeader(header))
+    {
+      *opp = getFwdPtr(p);
+      return;
+    }
+    if (pinType(header) != PIN_NONE || (MARK_MASK & header))
+    {
+      forwardHHObjptrParallel(s, opp, op, args);
+      return;
+    }
+  }
+}
+
+void parallelScanField(GC_state s, objptr *field, void *rawArgs)
+{
+  forwardHHObjptr(s, field, *field, rawArgs);
+}
+
+/* Owner side: open up the collection, trace until done, then wait for the
+ * helpers to leave. Returns the (zipped) toSpace heaps of all helpers. */
+HM_HierarchicalHeap scanInParallel(GC_state s, struct ForwardHHObjptrArgs *args)
+{
+  struct HM_HHC_parWork *w = args->parWork;
+  assert(w == s->lgcParWork);
+
+  w->ownerArgs = args;
+  w->helperToSpace = NULL;
+  w->bytesCopied = 0;
+  w->objectsCopied = 0;
+  w->stacksCopied = 0;
+  w->bytesMoved = 0;
+  w->objectsMoved = 0;
+
+  WT_open(s, &(w->team), NULL);
+  WT_drain(s, &(w->team), &(args->worklist), parallelScanField, args);
+#if ASSERT
+  bool drained = WT_close(s, &(w->team), &(args->worklist));
+  assert(drained);
+#else
+  WT_close(s, &(w->team), &(args->worklist));
+#endif
+  w->ownerArgs = NULL;
+
+  args->bytesCopied += w->bytesCopied;
+  args->objectsCopied += w->objectsCopied;
+  args->stacksCopied += w->stacksCopied;
+  args->bytesMoved += w->bytesMoved;
+  args->objectsMoved += w->objectsMoved;
+
+  LOG(LM_HH_COLLECTION, LL_INFO,
+      "parallel scan: helpers copied %" PRIu64 " objects, moved %" PRIu64,
+      w->objectsCopied,
+      w->objectsMoved);
+
+  return w->helperToSpace;
+}
+
 pointer copyObject(pointer p,
                    size_t objectSize,
                    size_t copySize,
@@ -19,6 +19,7 @@
 
 #include "chunk.h"
 #include "cc-work-list.h"
+#include "work-team.h"
 
 #if (defined(MLTON_GC_INTERNAL_TYPES))
 struct ForwardHHObjptrArgs
@@ -51,6 +52,34 @@ struct ForwardHHObjptrArgs
   /*worklist for mark and scan*/
   struct CC_workList worklist;
   bool concurrent;
+
+  /* non-NULL when tracing is shared with helpers (see HM_HHC_parWork).
+   * In this case, newly copied objects are pushed on the worklist instead of
+   * being Cheney-scanned in the toSpace. */
+  struct HM_HHC_parWork *parWork;
+};
+
+/* A local collection which is opened up to idle processors. Each processor
+ * has one of these, which is reused for each of its collections, so that
+ * helpers can always safely look at it.
+ *
+ * Helpers copy into their own toSpace heaps, which are handed back to the
+ * owner (zipped together as `helperToSpace`) when the helper leaves. The
+ * owner zips these into its own toSpace at the end of the collection.
+ */
+struct HM_HHC_parWork
+{
+  struct GC_workTeam team;
+
+  /* everything below is protected by the team's lock */
+  struct ForwardHHObjptrArgs *ownerArgs;
+  HM_HierarchicalHeap helperToSpace;
+
+  size_t bytesCopied;
+  uint64_t objectsCopied;
+  uint64_t stacksCopied;
+  size_t bytesMoved;
+  uint64_t objectsMoved;
 };
 
 struct checkDEDepthsArgs
@@ -66,6 +95,11 @@ struct checkDEDepthsArgs
 #endif /* MLTON_GC_INTERNAL_TYPES */
 
 #if (defined(MLTON_GC_INTERNAL_BASIS))
+/**
+ * Called by idle processors. If some other processor is performing a local
+ * collection that accepts helpers, help with it until it is finished.
+ */
+PRIVATE void GC_HH_helpLocalCollections(GC_state s);
 #endif /* MLTON_GC_INTERNAL_BASIS */
 
 #if (defined(MLTON_GC_INTERNAL_FUNCS))
@@ -74,6 +108,8 @@ struct checkDEDepthsArgs
  */
 void HM_HHC_collectLocal(uint32_t desiredScope);
 
+struct HM_HHC_parWork *HM_HHC_newParWork(void);
+
 /**
  * Forwards the object pointed to by 'opp' into 'destinationLevelList' starting
  * in its last chunk.
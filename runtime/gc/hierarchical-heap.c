@@ -133,8 +133,12 @@ void linkCCChains(
   size_t lenC2 = lengthOfCompletedCCChain(hh2);
 #endif
 
-  setCCChainDepth(hh2, hh1->depth);
-  setCompletedCCChainDepth(hh2, hh1->depth);
+  /* at a join the two heaps are already at the same depth, so the chains
+   * only need to be walked when promoting */
+  if (hh2->depth != hh1->depth) {
+    setCCChainDepth(hh2, hh1->depth);
+    setCompletedCCChainDepth(hh2, hh1->depth);
+  }
 
   if (NULL == hh1->subHeapForCC) {
     assert(NULL == hh1->subHeapCompletedCC);
@@ -239,7 +243,7 @@ HM_HierarchicalHeap HM_HH_zip(
       HM_appendChunkList(HM_HH_getChunkList(hh1), HM_HH_getChunkList(hh2));
       ES_move(HM_HH_getSuspects(hh1), HM_HH_getSuspects(hh2));
       HM_appendRemSet(HM_HH_getRemSet(hh1), HM_HH_getRemSet(hh2));
-
+      s->cumulativeStatistics->numJoinLevelsSpliced++;
 
       *cursor = hh1;
       cursor = &(hh1->nextAncestor);
@@ -315,6 +319,13 @@ void HM_HH_merge(
   assert(parentThread->hierarchicalHeap != NULL);
   assert(childThread->hierarchicalHeap != NULL);
 
+  struct timespec startTime;
+  struct timespec stopTime;
+  timespec_now(&startTime);
+
+  HM_HH_flushRememberBuffer(s);
+  s->writeBarrierLevelHead = NULL;
+
   HM_HierarchicalHeap parentHH = parentThread->hierarchicalHeap;
   HM_HierarchicalHeap childHH = childThread->hierarchicalHeap;
 
@@ -329,6 +340,14 @@ void HM_HH_merge(
   // free stack of joining heap
   CC_freeStack(s, HM_HH_getConcurrentPack(childHH));
 
+  /* The child has finished, so release the part of its ML stack that it
+   * grew into but is no longer using. */
+  if (0 < s->controls->stackReserve) {
+    GC_stack childStack = (GC_stack)objptrToPointer(childThread->stack, NULL);
+    if (NULL != HM_getChunkOf((pointer)childStack)->reservedLimit)
+      releaseStackUnused(s, childStack);
+  }
+
   /* Merge levels. */
   parentThread->hierarchicalHeap = HM_HH_zip(s, parentHH, childHH);
 
@@ -338,6 +357,11 @@ void HM_HH_merge(
     childThread->bytesAllocatedSinceLastCollection;
 
   assertInvariants(parentThread);
+
+  timespec_now(&stopTime);
+  timespec_sub(&stopTime, &startTime);
+  timespec_add(&(s->cumulativeStatistics->timeJoinMerge), &stopTime);
+  s->cumulativeStatistics->numJoinMerges++;
 }
 
 
@@ -365,6 +389,8 @@ void HM_HH_promoteChunks(
   GC_thread thread)
 {
   HM_HierarchicalHeap hh = thread->hierarchicalHeap;
+  HM_HH_flushRememberBuffer(s);
+  s->writeBarrierLevelHead = NULL;
 
   if (HM_HH_getDepth(hh) < thread->currentDepth)
   {
@@ -373,6 +399,12 @@ void HM_HH_promoteChunks(
     return;
   }
 
+  struct timespec startTime;
+  struct timespec stopTime;
+  timespec_now(&startTime);
+  struct PerfCounterSample perfStart;
+  bool perfSampling = beginPerfCounterPhase(s, &perfStart);
+
   uint32_t currentDepth = thread->currentDepth;
   assert(HM_HH_getDepth(hh) == currentDepth);
 
@@ -406,6 +438,7 @@ void HM_HH_promoteChunks(
       HM_appendChunkList(HM_HH_getChunkList(parent), HM_HH_getChunkList(hh));
       ES_move(HM_HH_getSuspects(parent), HM_HH_getSuspects(hh));
       HM_appendRemSet(HM_HH_getRemSet(parent), HM_HH_getRemSet(hh));
+      s->cumulativeStatistics->numJoinLevelsSpliced++;
       /* shortcut.  */
       thread->hierarchicalHeap = parent;
       hh = parent;
@@ -484,6 +517,13 @@ void HM_HH_promoteChunks(
   assertCCChainInvariants(thread->hierarchicalHeap);
   assertInvariants(thread);
 #endif
+
+  timespec_now(&stopTime);
+  timespec_sub(&stopTime, &startTime);
+  timespec_add(&(s->cumulativeStatistics->timeJoinPromote), &stopTime);
+  if (perfSampling)
+    endPerfCounterPhase(s, PERF_PHASE_PROMOTION, &perfStart);
+  s->cumulativeStatistics->numJoinPromotions++;
 }
 
 
@@ -512,6 +552,7 @@ HM_HierarchicalHeap HM_HH_new(GC_state s, uint32_t depth)
   HM_HH_getConcurrentPack(hh)->ccstate = CC_UNREG;
   HM_HH_getConcurrentPack(hh)->bytesSurvivedLastCollection = 0;
   HM_HH_getConcurrentPack(hh)->bytesAllocatedSinceLastCollection = 0;
+  HM_HH_getConcurrentPack(hh)->collection = NULL;
 
   // hh->representative = NULL;
   hh->ufNode = uf;
@@ -585,7 +626,12 @@ void HM_HH_ensureNotEmpty(GC_state s, GC_thread thread) {
   }
 }
 
-bool HM_HH_extend(GC_state s, GC_thread thread, size_t bytesRequested)
+static bool extendHeap(
+  GC_state s,
+  GC_thread thread,
+  size_t bytesRequested,
+  bool fresh,
+  bool withinHeapLimit)
 {
   HM_HierarchicalHeap hh = thread->hierarchicalHeap;
   uint32_t currentDepth = thread->currentDepth;
@@ -595,6 +641,7 @@ bool HM_HH_extend(GC_state s, GC_thread thread, size_t bytesRequested)
   assert(HM_HH_getDepth(hh) <= currentDepth);
 
   HM_chunk chunk;
+  HM_HierarchicalHeap parenthh = NULL;
 
   if (HM_HH_getDepth(hh) < currentDepth)
   {
@@ -602,15 +649,27 @@ bool HM_HH_extend(GC_state s, GC_thread thread, size_t bytesRequested)
     newhh->nextAncestor = hh;
     thread->hierarchicalHeap = newhh;
 
+    parenthh = hh;
     hh = newhh;
   }
 
-  chunk = HM_allocateChunkWithPurpose(
-    HM_HH_getChunkList(hh),
-    bytesRequested,
-    BLOCK_FOR_HEAP_CHUNK);
+  if (withinHeapLimit)
+    chunk = HM_tryAllocateHeapChunk(HM_HH_getChunkList(hh), bytesRequested, fresh);
+  else if (fresh)
+    chunk = HM_allocateFreshChunk(HM_HH_getChunkList(hh), bytesRequested);
+  else
+    chunk = HM_allocateChunkWithPurpose(
+      HM_HH_getChunkList(hh),
+      bytesRequested,
+      BLOCK_FOR_HEAP_CHUNK);
 
   if (NULL == chunk) {
+    /* don't leave an empty heap behind for the caller to collect */
+    if (NULL != parenthh) {
+      thread->hierarchicalHeap = parenthh;
+      freeFixedSize(getUFAllocator(s), HM_HH_getUFNode(hh));
+      freeFixedSize(getHHAllocator(s), hh);
+    }
     return FALSE;
   }
 
@@ -639,6 +698,23 @@ bool HM_HH_extend(GC_state s, GC_thread thread, size_t bytesRequested)
   return TRUE;
 }
 
+bool HM_HH_extend(GC_state s, GC_thread thread, size_t bytesRequested) {
+  return extendHeap(s, thread, bytesRequested, FALSE, FALSE);
+}
+
+bool HM_HH_extendFresh(GC_state s, GC_thread thread, size_t bytesRequested) {
+  return extendHeap(s, thread, bytesRequested, TRUE, FALSE);
+}
+
+bool HM_HH_tryExtend(
+  GC_state s,
+  GC_thread thread,
+  size_t bytesRequested,
+  bool fresh)
+{
+  return extendHeap(s, thread, bytesRequested, fresh, TRUE);
+}
+
 void HM_HH_forceLeftHeap(
   ARG_USED_FOR_ASSERT uint32_t processor,
   pointer threadp)
@@ -856,6 +932,10 @@ bool checkPolicyforRoot(
       return FALSE;
   }
 
+  /* near max-heap, collect anything big enough, whatever the ratio */
+  if (HM_HH_heapUnderPressure(s))
+    return TRUE;
+
   size_t bytesSurvived = HM_HH_getConcurrentPack(hh)->bytesSurvivedLastCollection;
   
   /* consider removing this: */
@@ -867,7 +947,7 @@ bool checkPolicyforRoot(
       HM_HH_getConcurrentPack(cursor)->bytesSurvivedLastCollection;
   }
 
-  if((s->controls->hhConfig.ccThresholdRatio * bytesSurvived) >
+  if((HM_HH_ccThresholdRatio(s) * bytesSurvived) >
       (HM_HH_getConcurrentPack(hh)->bytesAllocatedSinceLastCollection)
     || bytesSurvived == 0) {
     // if (!HM_HH_getConcurrentPack(hh)->shouldCollect) {
@@ -1040,6 +1120,8 @@ Bool HM_HH_registerCont(pointer kl, pointer kr, pointer k, pointer threadp) {
   getStackCurrent(s)->used = sizeofGCStateCurrentStackUsed(s);
   getThreadCurrent(s)->exnStack = s->exnStack;
   HM_HH_updateValues(getThreadCurrent(s), s->frontier);
+  HM_HH_flushRememberBuffer(s);
+  s->writeBarrierLevelHead = NULL;
 
   HM_HierarchicalHeap hh = thread->hierarchicalHeap;
   CC_initStack(s, HM_HH_getConcurrentPack(hh));
@@ -1133,13 +1215,236 @@ void HM_HH_updateValues(GC_thread thread, pointer frontier) {
 
 size_t HM_HH_nextCollectionThreshold(GC_state s, size_t survivingSize) {
   size_t threshold =
-    (size_t)((double)survivingSize * s->controls->hhConfig.collectionThresholdRatio);
+    (size_t)((double)survivingSize * HM_HH_collectionThresholdRatio(s));
   if (threshold < s->controls->hhConfig.minCollectionSize) {
     threshold = s->controls->hhConfig.minCollectionSize;
   }
   return threshold;
 }
 
+/* ========================================================================= */
+
+/* The adaptive policy only looks at windows of at least this many
+ * nanoseconds, and never scales a threshold by more than a factor of
+ * HM_HH_POLICY_MAX_STEP in one window. */
+#define HM_HH_POLICY_WINDOW_NS 10000000
+#define HM_HH_POLICY_MAX_STEP 2.0
+#define HM_HH_POLICY_MIN_RATIO 1.25
+#define HM_HH_POLICY_MAX_RATIO 64.0
+
+/* Fractions of max-heap: above the first, the heap is under pressure; above
+ * the second, even after collecting, the heap limit is considered exceeded,
+ * since what remains is about what a collection needs to copy into. */
+#define HM_HH_PRESSURE_FRACTION 0.75
+#define HM_HH_EXHAUSTED_FRACTION 0.9
+
+static inline bool adaptivePolicyEnabled(GC_state s) {
+  return s->controls->hhConfig.gcOverhead > 0.0
+      || s->controls->hhConfig.maxHeap > 0;
+}
+
+struct HM_HH_adaptivePolicy *HM_HH_newAdaptivePolicy(GC_state s) {
+  struct HM_HH_adaptivePolicy *p =
+    malloc_safe(sizeof(struct HM_HH_adaptivePolicy));
+  p->collectionThresholdRatio = s->controls->hhConfig.collectionThresholdRatio;
+  p->ccThresholdRatio = s->controls->hhConfig.ccThresholdRatio;
+  timespec_now(&(p->windowStart));
+  p->gcTimeAtWindowStart.tv_sec = 0;
+  p->gcTimeAtWindowStart.tv_nsec = 0;
+  p->bytesInScopeAtWindowStart = 0;
+  p->bytesReclaimedAtWindowStart = 0;
+  p->underPressure = FALSE;
+  p->pressureCheckedAt.tv_sec = 0;
+  p->pressureCheckedAt.tv_nsec = 0;
+  return p;
+}
+
+double HM_HH_collectionThresholdRatio(GC_state s) {
+  if (!adaptivePolicyEnabled(s))
+    return s->controls->hhConfig.collectionThresholdRatio;
+  return s->adaptivePolicy->collectionThresholdRatio;
+}
+
+double HM_HH_ccThresholdRatio(GC_state s) {
+  if (!adaptivePolicyEnabled(s))
+    return s->controls->hhConfig.ccThresholdRatio;
+  return s->adaptivePolicy->ccThresholdRatio;
+}
+
+/* Bytes of blocks which are currently allocated, over all processors. The
+ * counters are read racily, which is fine for a heuristic. */
+static size_t currentHeapInUse(GC_state s) {
+  size_t mapped;
+  size_t globalMapped;
+  size_t released;
+  size_t globalReleased;
+  size_t allocated[NUM_BLOCK_PURPOSES];
+  size_t freed[NUM_BLOCK_PURPOSES];
+  queryCurrentBlockUsage(
+    s,
+    &mapped,
+    &globalMapped,
+    &released,
+    &globalReleased,
+    (size_t*)allocated,
+    (size_t*)freed
+  );
+
+  size_t inUse = 0;
+  for (enum BlockPurpose p = 0; p < NUM_BLOCK_PURPOSES; p++) {
+    if (allocated[p] > freed[p])
+      inUse += allocated[p] - freed[p];
+  }
+  return inUse * s->controls->blockSize;
+}
+
+/* A threshold ratio r means we collect after allocating (r-1) times the
+ * surviving data, so the GC cost per allocated byte is roughly proportional
+ * to 1/(r-1). We therefore scale (r-1) by the observed overhead over the
+ * target, and then cap it so that the predicted peak (the surviving data,
+ * times r) fits in the max-heap budget. */
+static double adaptRatio(
+  double ratio,
+  double overheadScale,
+  double heapCap)
+{
+  double excess = (ratio - 1.0) * overheadScale;
+
+  /* limit the step size */
+  if (excess > (ratio - 1.0) * HM_HH_POLICY_MAX_STEP)
+    excess = (ratio - 1.0) * HM_HH_POLICY_MAX_STEP;
+  if (excess < (ratio - 1.0) / HM_HH_POLICY_MAX_STEP)
+    excess = (ratio - 1.0) / HM_HH_POLICY_MAX_STEP;
+
+  double newRatio = 1.0 + excess;
+  if (newRatio < HM_HH_POLICY_MIN_RATIO)
+    newRatio = HM_HH_POLICY_MIN_RATIO;
+  if (newRatio > HM_HH_POLICY_MAX_RATIO)
+    newRatio = HM_HH_POLICY_MAX_RATIO;
+
+  /* The heap cap comes last, so that neither the step limit nor the minimum
+   * ratio can push the predicted peak past max-heap. A ratio below 1.0
+   * would mean collecting before the heap has grown at all, so that is as
+   * far as it goes. */
+  if (newRatio > heapCap)
+    newRatio = (heapCap < 1.0) ? 1.0 : heapCap;
+  return newRatio;
+}
+
+void HM_HH_updateAdaptivePolicy(GC_state s) {
+  if (!adaptivePolicyEnabled(s))
+    return;
+
+  struct HM_HH_adaptivePolicy *p = s->adaptivePolicy;
+  struct GC_cumulativeStatistics *stats = s->cumulativeStatistics;
+
+  struct timespec now;
+  timespec_now(&now);
+  struct timespec elapsed = now;
+  timespec_sub(&elapsed, &(p->windowStart));
+  double elapsedNs = 1e9 * (double)elapsed.tv_sec + (double)elapsed.tv_nsec;
+  if (elapsedNs < HM_HH_POLICY_WINDOW_NS)
+    return;
+
+  struct timespec gcTime = stats->timeLocalGC;
+  timespec_add(&gcTime, &(stats->timeCC));
+  struct timespec windowGCTime = gcTime;
+  timespec_sub(&windowGCTime, &(p->gcTimeAtWindowStart));
+  double gcNs =
+    1e9 * (double)windowGCTime.tv_sec + (double)windowGCTime.tv_nsec;
+
+  uintmax_t inScope = (stats->bytesInScopeForLocal + stats->bytesInScopeForCC)
+                      - p->bytesInScopeAtWindowStart;
+  uintmax_t reclaimed = (stats->bytesReclaimedByLocal + stats->bytesReclaimedByCC)
+                        - p->bytesReclaimedAtWindowStart;
+  double survivalRate = 1.0;
+  if (inScope > 0 && reclaimed <= inScope)
+    survivalRate = 1.0 - (double)reclaimed / (double)inScope;
+
+  double overhead = gcNs / elapsedNs;
+  double overheadScale = 1.0;
+  if (s->controls->hhConfig.gcOverhead > 0.0) {
+    /* avoid dividing by zero when there was no GC in the window */
+    overheadScale =
+      (overhead + 1e-6) / s->controls->hhConfig.gcOverhead;
+  }
+
+  size_t inUse = 0;
+  double heapCap = HM_HH_POLICY_MAX_RATIO;
+  if (s->controls->hhConfig.maxHeap > 0) {
+    inUse = currentHeapInUse(s);
+    double live = survivalRate * (double)inUse;
+    if (live > 0.0) {
+      heapCap = (double)s->controls->hhConfig.maxHeap / live;
+    }
+    if (inUse > HM_HH_PRESSURE_FRACTION * (double)s->controls->hhConfig.maxHeap) {
+      /* nearly over budget: collect more eagerly, regardless of the overhead */
+      if (overheadScale > 1.0)
+        overheadScale = 1.0 / HM_HH_POLICY_MAX_STEP;
+    }
+  }
+
+  p->collectionThresholdRatio =
+    adaptRatio(p->collectionThresholdRatio, overheadScale, heapCap);
+  p->ccThresholdRatio =
+    adaptRatio(p->ccThresholdRatio, overheadScale, heapCap);
+
+  LOG(LM_HH_COLLECTION, LL_INFO,
+    "adaptive policy: overhead %.3lf survival %.3lf in use %zu "
+    "--> collection ratio %.2lf cc ratio %.2lf",
+    overhead,
+    survivalRate,
+    inUse,
+    p->collectionThresholdRatio,
+    p->ccThresholdRatio);
+
+  p->windowStart = now;
+  p->gcTimeAtWindowStart = gcTime;
+  p->bytesInScopeAtWindowStart =
+    stats->bytesInScopeForLocal + stats->bytesInScopeForCC;
+  p->bytesReclaimedAtWindowStart =
+    stats->bytesReclaimedByLocal + stats->bytesReclaimedByCC;
+}
+
+bool HM_HH_heapUnderPressure(GC_state s) {
+  size_t maxHeap = s->controls->hhConfig.maxHeap;
+  if (0 == maxHeap)
+    return FALSE;
+
+  /* The heap in use is at most what is mapped, which is cheap to read. */
+  double threshold = HM_HH_PRESSURE_FRACTION * (double)maxHeap;
+  if ((double)queryCurrentBytesMapped(s) < threshold)
+    return FALSE;
+
+  struct HM_HH_adaptivePolicy *p = s->adaptivePolicy;
+  struct timespec now;
+  timespec_now(&now);
+  struct timespec elapsed = now;
+  timespec_sub(&elapsed, &(p->pressureCheckedAt));
+  double elapsedNs = 1e9 * (double)elapsed.tv_sec + (double)elapsed.tv_nsec;
+  if (elapsedNs < HM_HH_POLICY_WINDOW_NS)
+    return p->underPressure;
+
+  p->underPressure = (double)currentHeapInUse(s) >= threshold;
+  p->pressureCheckedAt = now;
+  return p->underPressure;
+}
+
+void HM_HH_checkHeapLimit(GC_state s) {
+  size_t maxHeap = s->controls->hhConfig.maxHeap;
+  if (0 == maxHeap)
+    return;
+
+  size_t inUse = currentHeapInUse(s);
+  if ((double)inUse >= HM_HH_EXHAUSTED_FRACTION * (double)maxHeap) {
+    LOG(LM_HH_COLLECTION, LL_INFO,
+      "heap limit exceeded: %zu bytes in use after collection (max-heap %zu)",
+      inUse,
+      maxHeap);
+    setHeapLimitExceeded(s);
+  }
+}
+
 size_t HM_HH_addRecentBytesAllocated(GC_thread thread, size_t bytes) {
   thread->bytesAllocatedSinceLastCollection += bytes;
   return thread->bytesAllocatedSinceLastCollection;
@@ -1153,7 +1458,7 @@ uint32_t HM_HH_desiredCollectionScope(GC_state s, GC_thread thread)
     return thread->currentDepth+1; /* don't collect */
 
   if (thread->bytesAllocatedSinceLastCollection <
-      (s->controls->hhConfig.collectionThresholdRatio * thread->bytesSurvivedLastCollection))
+      (HM_HH_collectionThresholdRatio(s) * thread->bytesSurvivedLastCollection))
   {
     return thread->currentDepth+1; /* don't collect */
   }
@@ -1248,6 +1553,45 @@ void HM_HH_rememberAtLevel(HM_HierarchicalHeap hh, HM_remembered remElem, bool c
 
 }
 
+struct HM_HH_rememberBuffer *HM_HH_newRememberBuffer(void) {
+  struct HM_HH_rememberBuffer *buffer =
+    malloc_safe(sizeof(struct HM_HH_rememberBuffer));
+  buffer->size = 0;
+  return buffer;
+}
+
+void HM_HH_rememberBuffered(
+  GC_state s,
+  HM_HierarchicalHeap hh,
+  HM_remembered remElem)
+{
+  assert(hh != NULL);
+  struct HM_HH_rememberBuffer *buffer = s->rememberBuffer;
+  if (buffer->size == HM_HH_REMEMBER_BUFFER_SIZE) {
+    HM_HH_flushRememberBuffer(s);
+  }
+  buffer->heaps[buffer->size] = hh;
+  buffer->elems[buffer->size] = *remElem;
+  buffer->size++;
+}
+
+void HM_HH_flushRememberBuffer(GC_state s) {
+  struct HM_HH_rememberBuffer *buffer = s->rememberBuffer;
+  size_t i = 0;
+  /* consecutive entries usually go to the same heap */
+  while (i < buffer->size) {
+    HM_HierarchicalHeap hh = buffer->heaps[i];
+    assert(HM_HH_getConcurrentPack(hh)->ccstate == CC_UNREG);
+    size_t j = i+1;
+    while (j < buffer->size && buffer->heaps[j] == hh) {
+      j++;
+    }
+    HM_rememberMany(HM_HH_getRemSet(hh), &(buffer->elems[i]), j-i);
+    i = j;
+  }
+  buffer->size = 0;
+}
+
 
 void HM_HH_freeAllDependants(
   GC_state s,
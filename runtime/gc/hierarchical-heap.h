@@ -79,6 +79,40 @@ typedef struct HM_HierarchicalHeap {
 
 #define HM_HH_INVALID_DEPTH CHUNK_INVALID_DEPTH
 
+/* Down-pointers recorded by the write barrier are first collected here (one
+ * buffer per processor), and then appended in bulk to the private remembered
+ * sets of their heaps. The buffer only ever holds entries for heaps of the
+ * thread currently running on this processor, and it is flushed before
+ * anything could look at or restructure those heaps: before a local
+ * collection, a merge, a promotion, registering a heap for CC, and before
+ * switching to another thread. See HM_HH_flushRememberBuffer. */
+#define HM_HH_REMEMBER_BUFFER_SIZE 64
+
+struct HM_HH_rememberBuffer {
+  size_t size;
+  struct HM_HierarchicalHeap *heaps[HM_HH_REMEMBER_BUFFER_SIZE];
+  struct HM_remembered elems[HM_HH_REMEMBER_BUFFER_SIZE];
+};
+
+/* Per-processor state of the adaptive collection policy, which is enabled
+ * by @mpl gc-overhead or @mpl max-heap. The ratios here replace
+ * collectionThresholdRatio and ccThresholdRatio of the HM_HierarchicalHeapConfig,
+ * and are adjusted once per window (see HM_HH_updateAdaptivePolicy). */
+struct HM_HH_adaptivePolicy {
+  double collectionThresholdRatio;
+  double ccThresholdRatio;
+
+  /* start of the current window, and the counters at that point */
+  struct timespec windowStart;
+  struct timespec gcTimeAtWindowStart;
+  uintmax_t bytesInScopeAtWindowStart;
+  uintmax_t bytesReclaimedAtWindowStart;
+
+  /* cached result of HM_HH_heapUnderPressure, recomputed once per window */
+  bool underPressure;
+  struct timespec pressureCheckedAt;
+};
+
 #else
 
 struct HM_UnionFindNode;
@@ -125,11 +159,27 @@ bool HM_HH_isCCollecting(HM_HierarchicalHeap hh);
 void HM_HH_addRootForCollector(GC_state s, HM_HierarchicalHeap hh, pointer p);
 void HM_HH_rememberAtLevel(HM_HierarchicalHeap hh, HM_remembered remElem, bool conc);
 
+/* Same as HM_HH_rememberAtLevel(hh, remElem, false), except that the entry
+ * might only become visible at the next HM_HH_flushRememberBuffer. */
+void HM_HH_rememberBuffered(GC_state s, HM_HierarchicalHeap hh, HM_remembered remElem);
+void HM_HH_flushRememberBuffer(GC_state s);
+struct HM_HH_rememberBuffer *HM_HH_newRememberBuffer(void);
+
 void HM_HH_merge(GC_state s, GC_thread parent, GC_thread child);
 void HM_HH_promoteChunks(GC_state s, GC_thread thread);
 void HM_HH_ensureNotEmpty(GC_state s, GC_thread thread);
 
 bool HM_HH_extend(GC_state s, GC_thread thread, size_t bytesRequested);
+/* Like HM_HH_extend, but the new chunk is freshly mapped; see
+ * HM_allocateFreshChunk. */
+bool HM_HH_extendFresh(GC_state s, GC_thread thread, size_t bytesRequested);
+/* Like the above, but fails (leaving the heap as it was) instead of going
+ * past max-heap. See HM_ensureHeapWithinLimit. */
+bool HM_HH_tryExtend(
+  GC_state s,
+  GC_thread thread,
+  size_t bytesRequested,
+  bool fresh);
 
 /* zip-up hh1 and hh2, returning the new deepest leaf
  * (will be one of hh1 or hh2) */
@@ -147,6 +197,25 @@ pointer HM_HH_getLimit(GC_thread thread);
 void HM_HH_updateValues(GC_thread thread, pointer frontier);
 
 size_t HM_HH_nextCollectionThreshold(GC_state s, size_t survivingSize);
+
+struct HM_HH_adaptivePolicy *HM_HH_newAdaptivePolicy(GC_state s);
+double HM_HH_collectionThresholdRatio(GC_state s);
+double HM_HH_ccThresholdRatio(GC_state s);
+
+/* Called at the end of every local collection and CC. Compares the time
+ * spent in GC during the last window against wall-clock time, and the heap
+ * currently in use against the max-heap budget, and scales the thresholds
+ * accordingly. */
+void HM_HH_updateAdaptivePolicy(GC_state s);
+
+/* Whether the heap in use is close to max-heap. When it is, local
+ * collections and CCs are triggered as soon as there is enough to collect,
+ * regardless of the threshold ratios. */
+bool HM_HH_heapUnderPressure(GC_state s);
+
+/* Called after a collection forced by heap pressure. If the heap in use is
+ * still nearly at max-heap, tell the mutator (see GC_heapLimitExceeded). */
+void HM_HH_checkHeapLimit(GC_state s);
 size_t HM_HH_addRecentBytesAllocated(GC_thread thread, size_t bytes);
 
 uint32_t HM_HH_desiredCollectionScope(GC_state s, GC_thread thread);
@@ -195,6 +195,12 @@ int processAtMLton (GC_state s, int start, int argc, char **argv,
         } else if (0 == strcmp (arg, "set-affinity")) {
           i++;
           s->controls->setAffinity = TRUE;
+        } else if (0 == strcmp (arg, "follow-cpu-quota")) {
+          i++;
+          s->controls->followCPUQuota = TRUE;
+        } else if (0 == strcmp (arg, "perf-counters")) {
+          i++;
+          s->controls->perfCounters = TRUE;
         } else if (0 == strcmp (arg, "affinity-base")) {
           i++;
           if (i == argc || (0 == strcmp (argv[i], "--")))
@@ -208,6 +214,22 @@ int processAtMLton (GC_state s, int start, int argc, char **argv,
         } else if (0 == strcmp (arg, "debug-keep-free-blocks")) {
           i++;
           s->controls->debugKeepFreeBlocks = TRUE;
+        } else if (0 == strcmp (arg, "huge-pages")) {
+          i++;
+          s->controls->hugePages = TRUE;
+        } else if (0 == strcmp (arg, "release-empty-blocks")) {
+          i++;
+          s->controls->releaseEmptyBlocks = TRUE;
+        } else if (0 == strcmp (arg, "fresh-seq-min-size")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--")))
+            die ("%s fresh-seq-min-size missing argument.", atName);
+          s->controls->freshSequenceMinSize = stringToBytes (argv[i++]);
+        } else if (0 == strcmp (arg, "stack-reserve")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--")))
+            die ("%s stack-reserve missing argument.", atName);
+          s->controls->stackReserve = stringToBytes (argv[i++]);
         } else if (0 == strcmp (arg, "load-world")) {
           unless (s->controls->mayLoadWorld)
             die ("May not load world.");
@@ -318,8 +340,9 @@ int processAtMLton (GC_state s, int start, int argc, char **argv,
           if (!s->amOriginal)
             die ("%s %s incompatible with loaded worlds.", atName, arg);
           s->numberOfProcs = stringToFloat (argv[i++]);
-          /* Turn off loaded worlds -- they are unsuppoed in multi-proc mode */
-          s->controls->mayLoadWorld = FALSE;
+          /* Turn off loaded worlds -- they are unsupported in multi-proc mode */
+          if (s->numberOfProcs > 1)
+            s->controls->mayLoadWorld = FALSE;
         } else if ( (0 == strcmp(arg, "min-chunk")) ||
                     (0 == strcmp(arg, "block-size")) ) {
           i++;
@@ -378,6 +401,20 @@ int processAtMLton (GC_state s, int start, int argc, char **argv,
           struct timespec tm;
           stringToTime(argv[i++], &tm);
           s->controls->blockUsageSampleInterval = tm;
+        } else if (0 == strcmp(arg, "gc-stats-file")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--"))) {
+            die ("%s gc-stats-file missing argument.", atName);
+          }
+          s->controls->statsFile = argv[i++];
+        } else if (0 == strcmp(arg, "gc-stats-interval")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--"))) {
+            die ("%s gc-stats-interval missing argument.", atName);
+          }
+          struct timespec tm;
+          stringToTime(argv[i++], &tm);
+          s->controls->statsExportInterval = tm;
         } else if (0 == strcmp (arg, "collection-type")) {
           i++;
           if (i == argc || (0 == strcmp (argv[i], "--"))) {
@@ -416,6 +453,24 @@ int processAtMLton (GC_state s, int start, int argc, char **argv,
           if (s->controls->hhConfig.ccThresholdRatio <= 1.0) {
             die("%s cc-threshold-ratio must be > 1.0", atName);
           }
+        } else if (0 == strcmp(arg, "gc-overhead")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--"))) {
+            die ("%s gc-overhead missing argument.", atName);
+          }
+
+          s->controls->hhConfig.gcOverhead = stringToFloat(argv[i++]);
+          if (s->controls->hhConfig.gcOverhead <= 0.0 ||
+              s->controls->hhConfig.gcOverhead >= 1.0) {
+            die("%s gc-overhead must be between 0.0 and 1.0", atName);
+          }
+        } else if (0 == strcmp(arg, "max-heap")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--"))) {
+            die ("%s max-heap missing argument.", atName);
+          }
+
+          s->controls->hhConfig.maxHeap = stringToBytes(argv[i++]);
         } else if (0 == strcmp(arg, "min-collection-size")) {
           i++;
           if (i == argc || (0 == strcmp (argv[i], "--"))) {
@@ -430,6 +485,29 @@ int processAtMLton (GC_state s, int start, int argc, char **argv,
           }
 
           s->controls->hhConfig.minCCSize = stringToBytes(argv[i++]);
+        } else if (0 == strcmp(arg, "min-par-collection-size")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--"))) {
+            die ("%s min-par-collection-size missing argument.", atName);
+          }
+
+          s->controls->hhConfig.minParallelCollectionSize = stringToBytes(argv[i++]);
+        } else if (0 == strcmp(arg, "min-par-cc-size")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--"))) {
+            die ("%s min-par-cc-size missing argument.", atName);
+          }
+
+          s->controls->hhConfig.minParallelCCSize = stringToBytes(argv[i++]);
+        } else if (0 == strcmp(arg, "cc-slice")) {
+          i++;
+          if (i == argc || (0 == strcmp (argv[i], "--"))) {
+            die ("%s cc-slice missing argument.", atName);
+          }
+          struct timespec tm;
+          stringToTime(argv[i++], &tm);
+          s->controls->hhConfig.ccSliceTime =
+            (uint64_t)tm.tv_sec * 1000000000 + (uint64_t)tm.tv_nsec;
         } else if (0 == strcmp(arg, "max-cc-chain-length")) {
           i++;
           if (i == argc || (0 == strcmp (argv[i], "--"))) {
@@ -499,12 +577,15 @@ int GC_init (GC_state s, int argc, char **argv) {
   s->amOriginal = TRUE;
   s->atomicState = 0;
   s->callFromCHandlerThread = BOGUS_OBJPTR;
+  initPerfCounters(&(s->perfCounters));
 
   s->controls = (struct GC_controls *) malloc (sizeof (struct GC_controls));
-  s->controls->mayLoadWorld = FALSE; /* incompatible with mpl runtime */
+  s->controls->mayLoadWorld = TRUE;
   s->controls->mayProcessAtMLton = TRUE;
   s->controls->messages = FALSE;
   s->controls->setAffinity = FALSE;
+  s->controls->perfCounters = FALSE;
+  s->controls->followCPUQuota = FALSE;
   s->controls->affinityBase = 0;
   s->controls->affinityStride = 1;
   s->controls->ratios.ramSlop = 0.5f;
@@ -521,6 +602,11 @@ int GC_init (GC_state s, int argc, char **argv) {
   s->controls->hhConfig.ccThresholdRatio = 2.0f;
   s->controls->hhConfig.maxCCDepth = 3;
   s->controls->hhConfig.minLocalDepth = 2;
+  s->controls->hhConfig.minParallelCollectionSize = 0;
+  s->controls->hhConfig.minParallelCCSize = 0;
+  s->controls->hhConfig.ccSliceTime = 0;
+  s->controls->hhConfig.gcOverhead = 0.0;
+  s->controls->hhConfig.maxHeap = 0;
   s->controls->rusageMeasureGC = FALSE;
   s->controls->summary = FALSE;
   s->controls->summaryFormat = HUMAN;
@@ -536,6 +622,10 @@ int GC_init (GC_state s, int argc, char **argv) {
   s->controls->blockUsageSampleInterval.tv_sec = 1;
   s->controls->blockUsageSampleInterval.tv_nsec = 0;
 
+  s->controls->statsFile = NULL;
+  s->controls->statsExportInterval.tv_sec = 1;
+  s->controls->statsExportInterval.tv_nsec = 0;
+
   /* Not arbitrary; should be at least the page size and must also respect the
    * limit check coalescing amount in the compiler. */
   s->controls->blockSize = max(GC_pageSize(), 4096);
@@ -547,6 +637,10 @@ int GC_init (GC_state s, int argc, char **argv) {
 
   s->controls->freeListCoalesce = FALSE;
   s->controls->debugKeepFreeBlocks = FALSE;
+  s->controls->hugePages = FALSE;
+  s->controls->releaseEmptyBlocks = FALSE;
+  s->controls->freshSequenceMinSize = 0;
+  s->controls->stackReserve = 0;
 
   s->globalCumulativeStatistics = newGlobalCumulativeStatistics();
   s->cumulativeStatistics = newCumulativeStatistics();
@@ -566,6 +660,10 @@ int GC_init (GC_state s, int argc, char **argv) {
 
   initFixedSizeAllocator(getHHAllocator(s), sizeof(struct HM_HierarchicalHeap), BLOCK_FOR_HH_ALLOCATOR);
   initFixedSizeAllocator(getUFAllocator(s), sizeof(struct HM_UnionFindNode), BLOCK_FOR_UF_ALLOCATOR);
+  initSizeClassAllocator(getMetadataAllocator(s), BLOCK_FOR_METADATA);
+  s->lgcParWork = HM_HHC_newParWork();
+  s->ccParMark = CC_newParMark();
+  s->rememberBuffer = HM_HH_newRememberBuffer();
   s->numberDisentanglementChecks = 0;
 
   s->signalHandlerThread = BOGUS_OBJPTR;
@@ -646,6 +744,9 @@ int GC_init (GC_state s, int argc, char **argv) {
     die("alloc-blocks-min-size must be a multiple of the block-size (%zu)",
       s->controls->blockSize);
 
+  s->blockMask = ~(s->controls->blockSize - 1);
+  s->writeBarrierLevelHead = NULL;
+
   unless (s->controls->superblockThreshold <= s->controls->megablockThreshold)
     die("superblock-threshold (currently %zu) must be at most the megablock-threshold (currently %zu)",
       s->controls->superblockThreshold,
@@ -664,10 +765,13 @@ void GC_lateInit(GC_state s) {
 
   initLocalBlockAllocator(s, initGlobalBlockAllocator(s));
   s->blockUsageSampler = newBlockUsageSampler(s);
+  s->statsExportSampler = newStatsExportSampler(s);
 
   s->nextChunkAllocSize = s->controls->allocChunkSize;
+  s->adaptivePolicy = HM_HH_newAdaptivePolicy(s);
 
   set_max_gdtoa_threads(s->numberOfProcs);
+  Parallel_initActive(s);
 
   /* Initialize profiling.  This must occur after processing
    * command-line arguments, because those may just be doing a
@@ -678,7 +782,7 @@ void GC_lateInit(GC_state s) {
   if (s->amOriginal) {
     initWorld (s);
   } else {
-    DIE("loading world from file unsupported");
+    loadWorldFromFileName (s, s->worldFile);
   }
   s->amInGC = FALSE;
 }
@@ -686,6 +790,7 @@ void GC_lateInit(GC_state s) {
 void GC_duplicate (GC_state d, GC_state s) {
   // GC_init
   d->amInGC = s->amInGC;
+  d->blockMask = s->blockMask;
   d->currentCCTargetHH = NULL;
   // d->amInCC = s->amInCC;
   d->amOriginal = s->amOriginal;
@@ -700,8 +805,16 @@ void GC_duplicate (GC_state d, GC_state s) {
   d->wsQueueBot = BOGUS_OBJPTR;
   initLocalBlockAllocator(d, s->blockAllocatorGlobal);
   d->blockUsageSampler = s->blockUsageSampler;
+  d->statsExportSampler = s->statsExportSampler;
+  initPerfCounters(&(d->perfCounters));
   initFixedSizeAllocator(getHHAllocator(d), sizeof(struct HM_HierarchicalHeap), BLOCK_FOR_HH_ALLOCATOR);
   initFixedSizeAllocator(getUFAllocator(d), sizeof(struct HM_UnionFindNode), BLOCK_FOR_UF_ALLOCATOR);
+  initSizeClassAllocator(getMetadataAllocator(d), BLOCK_FOR_METADATA);
+  d->lgcParWork = HM_HHC_newParWork();
+  d->ccParMark = CC_newParMark();
+  d->rememberBuffer = HM_HH_newRememberBuffer();
+  d->writeBarrierLevelHead = NULL;
+  d->adaptivePolicy = HM_HH_newAdaptivePolicy(d);
   d->hhEBR = s->hhEBR;
   d->hmEBR = s->hmEBR;
   d->nextChunkAllocSize = s->nextChunkAllocSize;
@@ -732,8 +845,7 @@ void GC_duplicate (GC_state d, GC_state s) {
 
   d->sysvals.ram = s->sysvals.ram;
 
-  // SPOONHOWER_NOTE: better duplicate
-  //initProfiling (d);
+  duplicateProfiling (d, s);
 
   // Multi-processor support is incompatible with saved-worlds
   assert(d->amOriginal);
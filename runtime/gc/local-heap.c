@@ -32,6 +32,78 @@ void HM_exitLocalHeap (GC_state s) {
   HM_HH_updateValues(getThreadCurrent(s), s->frontier);
 }
 
+/* Collect the current thread's heap up to desiredScope, and reset the
+ * frontier afterwards. */
+static void collectLocal(GC_state s, uint32_t desiredScope) {
+  HM_HHC_collectLocal(desiredScope);
+
+  /* post-collection, the thread might have been moved? */
+  GC_thread thread = getThreadCurrent(s);
+
+  if (NULL == thread->currentChunk) {
+    /* collected everything! */
+    s->frontier = NULL;
+    s->limitPlusSlop = NULL;
+    s->limit = NULL;
+  } else {
+    /* SAM_NOTE: I don't use HM_HH_getFrontier/Limit here, because these have
+     * assertions for the chunk frontier invariant, which might be violated
+     * here. */
+    s->frontier = HM_getChunkFrontier(thread->currentChunk);
+    s->limitPlusSlop = HM_getChunkLimit(thread->currentChunk);
+    s->limit = s->limitPlusSlop - GC_HEAP_LIMIT_SLOP;
+  }
+
+  /* Thread/stack may have been copied during GC, so need to update */
+  setGCStateCurrentThreadAndStack (s);
+}
+
+void HM_collectForHeapLimit(GC_state s) {
+  GC_thread thread = getThreadCurrent(s);
+
+  /* Everything this thread may collect: its private heaps locally, and any
+   * public ancestors that are waiting for a CC right here instead of in a
+   * GC task. */
+  if (s->wsQueueTop != BOGUS_OBJPTR &&
+      thread->currentDepth <= (uint32_t)thread->disentangledDepth)
+  {
+    collectLocal(s, 1);
+    thread = getThreadCurrent(s);
+  }
+  for (uint32_t depth = 1; depth < thread->currentDepth; depth++)
+    CC_collectAtPublicLevel(s, thread, depth);
+}
+
+bool HM_extendHeapWithinLimit(
+  GC_state s,
+  size_t bytesRequested,
+  bool fresh)
+{
+  GC_thread thread = getThreadCurrent(s);
+  if (HM_HH_tryExtend(s, thread, bytesRequested, fresh))
+    return TRUE;
+
+  LOG(LM_HH_COLLECTION, LL_INFO,
+    "max-heap refused %zu bytes; collecting before trying again",
+    bytesRequested);
+
+  HM_collectForHeapLimit(s);
+  thread = getThreadCurrent(s);
+  if (HM_HH_tryExtend(s, thread, bytesRequested, fresh))
+    return TRUE;
+
+  /* Still nothing: go past max-heap this once, and let the mutator know,
+   * since it can't be handed a failed allocation. */
+  setHeapLimitExceeded(s);
+  bool extended =
+    fresh ? HM_HH_extendFresh(s, thread, bytesRequested)
+          : HM_HH_extend(s, thread, bytesRequested);
+  if (!extended) {
+    DIE("Ran out of space for Hierarchical Heap!");
+  }
+  return FALSE;
+}
+
 void HM_ensureHierarchicalHeapAssurances(
   GC_state s,
   bool forceGC,
@@ -81,6 +153,17 @@ void HM_ensureHierarchicalHeapAssurances(
   uint32_t desiredScope = 1;
   if (!forceGC) desiredScope = HM_HH_desiredCollectionScope(s, thread);
 
+  /* Near max-heap, don't wait for the threshold ratio: collect as much as
+   * possible once there is enough new data to be worth a collection, and
+   * afterwards check whether that freed up enough to carry on. */
+  bool pressure =
+    desiredScope > thread->currentDepth &&
+    thread->bytesAllocatedSinceLastCollection >=
+      s->controls->hhConfig.minCollectionSize &&
+    s->wsQueueTop != BOGUS_OBJPTR &&
+    HM_HH_heapUnderPressure(s);
+  if (pressure) desiredScope = 1;
+
   if (desiredScope <= thread->currentDepth &&
       thread->currentDepth <= (uint32_t)thread->disentangledDepth)
   {
@@ -89,27 +172,10 @@ void HM_ensureHierarchicalHeapAssurances(
     //     CC_collectAtPublicLevel(s, thread, i);
     // }
 
-    HM_HHC_collectLocal(desiredScope);
-
-    /* post-collection, the thread might have been moved? */
+    collectLocal(s, desiredScope);
     thread = getThreadCurrent(s);
 
-    if (NULL == thread->currentChunk) {
-      /* collected everything! */
-      s->frontier = NULL;
-      s->limitPlusSlop = NULL;
-      s->limit = NULL;
-    } else {
-      /* SAM_NOTE: I don't use HM_HH_getFrontier/Limit here, because these have
-       * assertions for the chunk frontier invariant, which might be violated
-       * here. */
-      s->frontier = HM_getChunkFrontier(thread->currentChunk);
-      s->limitPlusSlop = HM_getChunkLimit(thread->currentChunk);
-      s->limit = s->limitPlusSlop - GC_HEAP_LIMIT_SLOP;
-    }
-
-    /* Thread/stack may have been copied during GC, so need to update */
-    setGCStateCurrentThreadAndStack (s);
+    if (pressure) HM_HH_checkHeapLimit(s);
   }
 
   if (growStack) {
@@ -135,9 +201,8 @@ void HM_ensureHierarchicalHeapAssurances(
       !thread->currentChunk->mightContainMultipleObjects ||
       (size_t)(s->limitPlusSlop - s->frontier) < bytesRequested)
   {
-    if (!HM_HH_extend(s, thread, bytesRequested)) {
-      DIE("Ran out of space for Hierarchical Heap!");
-    }
+    HM_extendHeapWithinLimit(s, bytesRequested, FALSE);
+    thread = getThreadCurrent(s);
     s->frontier = HM_HH_getFrontier(thread);
     s->limitPlusSlop = HM_HH_getLimit(thread);
     s->limit = s->limitPlusSlop - GC_HEAP_LIMIT_SLOP;
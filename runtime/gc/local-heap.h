@@ -45,6 +45,31 @@ void HM_ensureHierarchicalHeapAssurances(GC_state s,
                                          bool forceGC,
                                          size_t bytesRequested,
                                          bool ensureCurrentLevel);
+
+/**
+ * Collect as much as the current thread can right now, because the heap is
+ * at max-heap: its private heaps, and any public ancestors registered for a
+ * CC. Resets the frontier, so anything pointing into the heap is invalid
+ * afterwards.
+ *
+ * @param s The GC_state to operate on
+ */
+void HM_collectForHeapLimit(GC_state s);
+
+/**
+ * Extend the heap of the current thread with a new chunk, as HM_HH_extend.
+ * If that would go past max-heap, first collect as much as possible and try
+ * again. If it still would, extend anyway and set the flag polled by the
+ * mutator (see GC_heapLimitExceeded), which raises HeapLimitExceeded at its
+ * next allocation or fork.
+ *
+ * @param s The GC_state to operate on
+ * @param bytesRequested The minimum number of bytes free in the new chunk
+ * @param fresh Whether the new chunk should be freshly mapped
+ *
+ * @return TRUE if the heap stayed within max-heap
+ */
+bool HM_extendHeapWithinLimit(GC_state s, size_t bytesRequested, bool fresh);
 #endif /* MLTON_GC_INTERNAL_FUNCS */
 
 #endif /* LOCAL_HEAP_H_ */
@@ -9,11 +9,17 @@
 
 #if (defined (MLTON_GC_INTERNAL_TYPES))
 
-#define DEQUE_CAPACITY_BITS   10
-#define MAX_IDX               ((((uint64_t)1) << DEQUE_CAPACITY_BITS) - 1)
-#define UNPACK_TAG(topval)    ((topval) >> DEQUE_CAPACITY_BITS)
+/* The top of a work-stealing deque packs a tag and an index into a 64-bit
+ * word (see TagIdx in basis-library/schedulers/shh/queue/DequeABP.sml).
+ * Indices are fork depths, as wide as the 32-bit bottom index; the deque
+ * maps them onto its circular array itself, so its capacity does not
+ * appear here.
+ */
+#define DEQUE_IDX_BITS        32
+#define MAX_IDX               ((((uint64_t)1) << DEQUE_IDX_BITS) - 1)
+#define UNPACK_TAG(topval)    ((topval) >> DEQUE_IDX_BITS)
 #define UNPACK_IDX(topval)    ((topval) & MAX_IDX)
-#define PACK_TAGIDX(tag, idx) (((tag) << DEQUE_CAPACITY_BITS) | (idx))
+#define PACK_TAGIDX(tag, idx) (((tag) << DEQUE_IDX_BITS) | (idx))
 
 #endif /* defined (MLTON_GC_INTERNAL_TYPES) */
 
@@ -137,10 +137,6 @@ GC_thread newThreadWithHeap(
 {
   size_t stackSize = sizeofStackWithMetaData(s, reserved);
   size_t threadSize = sizeofThread(s);
-  size_t totalSize = stackSize + threadSize;
-
-  if (reserved > s->cumulativeStatistics->maxStackSize)
-    s->cumulativeStatistics->maxStackSize = reserved;
 
   /* Allocate and initialize the heap that will be assigned to this thread.
    * Can't just use HM_HH_extend, because the corresponding thread doesn't exist
@@ -164,6 +160,23 @@ GC_thread newThreadWithHeap(
   sChunk->levelHead = HM_HH_getUFNode(hh);
   sChunk->mightContainMultipleObjects = FALSE;
 
+  /* The stack has its chunk to itself, so reserve all of it up front. A
+   * freshly copied task thread then runs without trips into the runtime to
+   * grow its stack until it outgrows the chunk. */
+  size_t chunkReserved =
+    alignDown((size_t)(HM_getChunkLimit(sChunk) - HM_getChunkFrontier(sChunk)),
+              s->alignment)
+    - GC_STACK_METADATA_SIZE - sizeof(struct GC_stack);
+  if (chunkReserved > reserved) {
+    reserved = chunkReserved;
+    assert(isStackReservedAligned(s, reserved));
+    stackSize = sizeofStackWithMetaData(s, reserved);
+  }
+  size_t totalSize = stackSize + threadSize;
+
+  if (reserved > s->cumulativeStatistics->maxStackSize)
+    s->cumulativeStatistics->maxStackSize = reserved;
+
 #ifdef DETECT_ENTANGLEMENT
   decheck_tid_t decheckState =
     (existsCurrentThread ?
@@ -176,7 +189,7 @@ GC_thread newThreadWithHeap(
   sChunk->decheckState = decheckState;
 
   assert(threadSize < HM_getChunkSizePastFrontier(tChunk));
-  assert(stackSize < HM_getChunkSizePastFrontier(sChunk));
+  assert(stackSize <= HM_getChunkSizePastFrontier(sChunk));
 
   pointer tFrontier = HM_getChunkFrontier(tChunk);
   pointer sFrontier = HM_getChunkFrontier(sChunk);
@@ -155,6 +155,169 @@ uint64_t Parallel_getTimeInGC (void) {
   return gcTime;
 }
 
+// idle processors
+
+/* Every wakeup bumps Parallel_idleEpoch, and a processor only parks if the
+ * epoch still has the value it read in Parallel_idlePrepare, before its last
+ * check for work. So a wakeup that races with that check is never lost.
+ */
+static volatile Word32 Parallel_idleEpoch = 0;
+Word32 Parallel_numParked = 0;
+
+Word32 Parallel_idlePrepare (void) {
+  Word32 epoch = __atomic_load_n (&Parallel_idleEpoch, __ATOMIC_SEQ_CST);
+  __sync_fetch_and_add (&Parallel_numParked, 1);
+  return epoch;
+}
+
+void Parallel_idleCancel (void) {
+  __sync_fetch_and_sub (&Parallel_numParked, 1);
+}
+
+/* A parked processor holds no references into the heap, but its last EBR
+ * announcement is non-quiescent and would stop both epochs from advancing
+ * for as long as it sleeps. So it announces quiescence for the duration.
+ * Leaving again may reclaim retired records and chunks, so it comes before
+ * the processor goes back to the mutator.
+ */
+static void enterParkedState (GC_state s) {
+  HH_EBR_enterQuiescentState (s);
+  HM_EBR_enterQuiescentState (s);
+}
+
+static void leaveParkedState (GC_state s) {
+  HH_EBR_leaveQuiescentState (s);
+  HM_EBR_leaveQuiescentState (s);
+}
+
+void GC_idlePark (GC_state s, Word32 epoch, Word64 timeoutNs) {
+  struct timespec timeout;
+  timeout.tv_sec = timeoutNs / 1000000000;
+  timeout.tv_nsec = timeoutNs % 1000000000;
+
+  enterParkedState (s);
+#if HAS_FUTEX
+  if (__atomic_load_n (&Parallel_idleEpoch, __ATOMIC_SEQ_CST) == epoch)
+    syscall (SYS_futex, &Parallel_idleEpoch, FUTEX_WAIT_PRIVATE,
+             epoch, &timeout, NULL, 0);
+#else
+  if (__atomic_load_n (&Parallel_idleEpoch, __ATOMIC_SEQ_CST) == epoch)
+    nanosleep (&timeout, NULL);
+#endif
+  __sync_fetch_and_sub (&Parallel_numParked, 1);
+  leaveParkedState (s);
+
+  GC_MayTerminateThread (s);
+}
+
+void Parallel_idleWake (Word32 count) {
+  if (0 == __atomic_load_n (&Parallel_numParked, __ATOMIC_SEQ_CST))
+    return;
+  __sync_fetch_and_add (&Parallel_idleEpoch, 1);
+#if HAS_FUTEX
+  syscall (SYS_futex, &Parallel_idleEpoch, FUTEX_WAKE_PRIVATE,
+           (count > INT_MAX) ? INT_MAX : (int)count, NULL, NULL, 0);
+#else
+  (void)count;
+#endif
+}
+
+void Parallel_idleWakeOne (void) {
+  Parallel_idleWake (1);
+}
+
+// active processors
+
+/* Inactive processors wait on Parallel_activeEpoch rather than the idle
+ * epoch, so that they never absorb a wakeup meant for an idle active
+ * processor. Every change of Parallel_numActive bumps the epoch.
+ */
+Word32 Parallel_numActive = 1;
+static volatile Word32 Parallel_activeEpoch = 0;
+static volatile uint64_t Parallel_lastQuotaPollNs = 0;
+
+static void setNumActive (GC_state s, Word32 n) {
+  if (n < 1)
+    n = 1;
+  if (n > s->numberOfProcs)
+    n = s->numberOfProcs;
+
+  Word32 old = __atomic_exchange_n (&Parallel_numActive, n, __ATOMIC_SEQ_CST);
+  if (old == n)
+    return;
+
+  LOG(LM_PARALLEL, LL_INFO,
+      "active processors: %"PRIu32" -> %"PRIu32,
+      old, n);
+
+  __sync_fetch_and_add (&Parallel_activeEpoch, 1);
+#if HAS_FUTEX
+  syscall (SYS_futex, &Parallel_activeEpoch, FUTEX_WAKE_PRIVATE,
+           INT_MAX, NULL, NULL, 0);
+#endif
+  /* Idle processors that are no longer active should notice. */
+  if (n < old)
+    Parallel_idleWake (s->numberOfProcs);
+}
+
+static void pollCPUQuota (GC_state s, bool force) {
+  if (!s->controls->followCPUQuota)
+    return;
+
+  struct timespec now;
+  timespec_now (&now);
+  uint64_t nowNs = (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+  uint64_t last = __atomic_load_n (&Parallel_lastQuotaPollNs, __ATOMIC_SEQ_CST);
+  if (!force && nowNs - last < CPU_QUOTA_POLL_INTERVAL_NS)
+    return;
+  if (!__sync_bool_compare_and_swap (&Parallel_lastQuotaPollNs, last, nowNs))
+    return;
+
+  uint32_t quota = GC_cpuQuota ();
+  setNumActive (s, (0 == quota) ? s->numberOfProcs : quota);
+}
+
+void Parallel_initActive (GC_state s) {
+  Parallel_numActive = s->numberOfProcs;
+  pollCPUQuota (s, TRUE);
+}
+
+void Parallel_setNumActive (Word32 n) {
+  GC_state s = pthread_getspecific (gcstate_key);
+  setNumActive (s, n);
+}
+
+void Parallel_pollCPUQuota (void) {
+  GC_state s = pthread_getspecific (gcstate_key);
+  pollCPUQuota (s, FALSE);
+}
+
+void GC_parkInactive (GC_state s) {
+  Word32 epoch = __atomic_load_n (&Parallel_activeEpoch, __ATOMIC_SEQ_CST);
+  pollCPUQuota (s, FALSE);
+
+  if ((Word32)Proc_processorNumber (s) < __atomic_load_n (&Parallel_numActive, __ATOMIC_SEQ_CST))
+    return;
+
+  /* Wake up now and then to poll the quota, and to let GC_MayTerminateThread
+   * run. */
+  struct timespec timeout;
+  timeout.tv_sec = 0;
+  timeout.tv_nsec = CPU_QUOTA_POLL_INTERVAL_NS;
+
+  enterParkedState (s);
+#if HAS_FUTEX
+  syscall (SYS_futex, &Parallel_activeEpoch, FUTEX_WAIT_PRIVATE,
+           epoch, &timeout, NULL, 0);
+#else
+  (void)epoch;
+  nanosleep (&timeout, NULL);
+#endif
+  leaveParkedState (s);
+
+  GC_MayTerminateThread (s);
+}
+
 // fetchAndAdd implementations
 
 Int8 Parallel_fetchAndAdd8 (pointer p, Int8 v) {
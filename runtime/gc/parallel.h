@@ -1,4 +1,17 @@
 
+#define CPU_QUOTA_POLL_INTERVAL_NS 100000000
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+/* Wakes up to count parked idle processors; cheap if none are parked. */
+void Parallel_idleWake (Word32 count);
+
+/* Makes all processors active, or as many as the CPU quota allows if
+ * following it. */
+void Parallel_initActive (GC_state s);
+
+#endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
+
 #if (defined (MLTON_GC_INTERNAL_BASIS))
 
 PRIVATE void Parallel_init (void);
@@ -26,4 +39,27 @@ PRIVATE Int16 Parallel_arrayFetchAndAdd16 (pointer p, GC_sequenceLength i, Int16
 PRIVATE Int32 Parallel_arrayFetchAndAdd32 (pointer p, GC_sequenceLength i, Int32 v);
 PRIVATE Int64 Parallel_arrayFetchAndAdd64 (pointer p, GC_sequenceLength i, Int64 v);
 
+/* Parking idle processors. A processor that has failed to find work calls
+ * Parallel_idlePrepare, checks once more for work, and then either calls
+ * GC_idlePark with the returned epoch or Parallel_idleCancel. A processor
+ * that makes work available calls Parallel_idleWake when
+ * Parallel_numParked is nonzero.
+ */
+PRIVATE extern Word32 Parallel_numParked;
+PRIVATE Word32 Parallel_idlePrepare (void);
+PRIVATE void Parallel_idleCancel (void);
+PRIVATE void GC_idlePark (GC_state s, Word32 epoch, Word64 timeoutNs);
+PRIVATE void Parallel_idleWakeOne (void);
+
+/* Elastic parallelism. Only processors numbered below Parallel_numActive
+ * look for work; the others park in GC_parkInactive, which returns when
+ * the count changes (or after a timeout), and the caller checks again.
+ * Parallel_pollCPUQuota updates the count from the cgroup CPU quota, at
+ * most once per CPU_QUOTA_POLL_INTERVAL_NS, when following the quota.
+ */
+PRIVATE extern Word32 Parallel_numActive;
+PRIVATE void Parallel_setNumActive (Word32 n);
+PRIVATE void GC_parkInactive (GC_state s);
+PRIVATE void Parallel_pollCPUQuota (void);
+
 #endif /* (defined (MLTON_GC_INTERNAL_BASIS)) */
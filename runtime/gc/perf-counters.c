@@ -0,0 +1,179 @@
+/* MLton is released under a HPND-style license.
+ * See the file MLton-LICENSE for details.
+ */
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+void initPerfCounters(struct PerfCounters *pc) {
+  pc->leaderFd = -1;
+  pc->numOpen = 0;
+  for (uint32_t i = 0; i < GC_PERF_NUM_EVENTS; i++) {
+    pc->fds[i] = -1;
+    pc->events[i] = GC_PERF_NUM_EVENTS;
+  }
+  pc->inPhase = FALSE;
+  pc->multiplexed = FALSE;
+}
+
+
+/* Read the running totals. Only the owner of pc passes multiplexed, to note
+ * (and report, the first time) that the counts are scaled estimates. */
+static bool readPerfCounters(
+  GC_state s,
+  struct PerfCounters *pc,
+  struct PerfCounterSample *sample,
+  bool *multiplexed)
+{
+  uint64_t values[GC_PERF_NUM_EVENTS];
+  bool wasMultiplexed;
+  if (!GC_perfCounterReadGroup(pc->leaderFd, pc->numOpen, values, &wasMultiplexed))
+    return FALSE;
+
+  if (NULL != multiplexed && wasMultiplexed && !*multiplexed) {
+    *multiplexed = TRUE;
+    LOG(LM_GC_STATE, LL_WARNING,
+      "perf-counters: counters multiplexed on processor %u; counts are scaled estimates",
+      s->procNumber);
+  }
+
+  for (uint32_t e = 0; e < GC_PERF_NUM_EVENTS; e++)
+    sample->values[e] = 0;
+  for (uint32_t i = 0; i < pc->numOpen; i++)
+    sample->values[pc->events[i]] = values[i];
+  return TRUE;
+}
+
+
+bool beginPerfCounterPhase(GC_state s, struct PerfCounterSample *start) {
+  struct PerfCounters *pc = &(s->perfCounters);
+  if (pc->leaderFd < 0 || pc->inPhase)
+    return FALSE;
+  if (!readPerfCounters(s, pc, start, &(pc->multiplexed)))
+    return FALSE;
+  pc->inPhase = TRUE;
+  return TRUE;
+}
+
+
+void endPerfCounterPhase(
+  GC_state s,
+  enum PerfCounterPhase phase,
+  struct PerfCounterSample *start)
+{
+  struct PerfCounters *pc = &(s->perfCounters);
+  assert(pc->inPhase);
+  assert(phase != PERF_PHASE_MUTATOR);
+  pc->inPhase = FALSE;
+
+  struct PerfCounterSample stop;
+  if (!readPerfCounters(s, pc, &stop, &(pc->multiplexed)))
+    return;
+
+  uint64_t *counts = s->cumulativeStatistics->perfCounts[phase];
+  for (uint32_t e = 0; e < GC_PERF_NUM_EVENTS; e++) {
+    if (stop.values[e] > start->values[e])
+      counts[e] += stop.values[e] - start->values[e];
+  }
+}
+
+
+/* The MUTATOR counts of s, i.e., its running totals less the counts of the
+ * other phases. Writes nothing, so any processor may call this. */
+static bool computePerfCountsMutator(
+  GC_state s,
+  uint64_t *mutator,
+  bool *multiplexed)
+{
+  struct PerfCounters *pc = &(s->perfCounters);
+  struct PerfCounterSample total;
+  if (pc->leaderFd < 0 || !readPerfCounters(s, pc, &total, multiplexed))
+    return FALSE;
+
+  uint64_t (*counts)[GC_PERF_NUM_EVENTS] = s->cumulativeStatistics->perfCounts;
+  for (uint32_t e = 0; e < GC_PERF_NUM_EVENTS; e++) {
+    uint64_t inGC = 0;
+    for (uint32_t phase = 0; phase < PERF_NUM_PHASES; phase++) {
+      if (phase != PERF_PHASE_MUTATOR)
+        inGC += counts[phase][e];
+    }
+    mutator[e] = total.values[e] > inGC ? total.values[e] - inGC : 0;
+  }
+  return TRUE;
+}
+
+
+void updatePerfCountersMutator(GC_state s) {
+  uint64_t mutator[GC_PERF_NUM_EVENTS];
+  if (!computePerfCountsMutator(s, mutator, &(s->perfCounters.multiplexed)))
+    return;
+
+  uint64_t *counts = s->cumulativeStatistics->perfCounts[PERF_PHASE_MUTATOR];
+  for (uint32_t e = 0; e < GC_PERF_NUM_EVENTS; e++)
+    counts[e] = mutator[e];
+}
+
+
+void closePerfCounters(GC_state s) {
+  struct PerfCounters *pc = &(s->perfCounters);
+  if (pc->leaderFd < 0)
+    return;
+
+  updatePerfCountersMutator(s);
+
+  pc->leaderFd = -1;
+  for (uint32_t i = 0; i < pc->numOpen; i++) {
+    GC_perfCounterClose(pc->fds[i]);
+    pc->fds[i] = -1;
+  }
+  pc->numOpen = 0;
+}
+
+#endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
+
+
+void GC_perfCountersThreadInit(GC_state s) {
+  struct PerfCounters *pc = &(s->perfCounters);
+  if (!s->controls->perfCounters || pc->leaderFd >= 0)
+    return;
+
+  for (uint32_t event = 0; event < GC_PERF_NUM_EVENTS; event++) {
+    int fd = GC_perfCounterOpen(event, pc->leaderFd);
+    if (fd < 0) {
+      if (pc->leaderFd < 0) {
+        /* Without cycles there is no group; give up on this processor. */
+        LOG(LM_GC_STATE, LL_WARNING,
+          "perf-counters: could not open counters on processor %u",
+          s->procNumber);
+        return;
+      }
+      continue;
+    }
+    if (pc->leaderFd < 0)
+      pc->leaderFd = fd;
+    pc->fds[pc->numOpen] = fd;
+    pc->events[pc->numOpen] = event;
+    pc->numOpen++;
+  }
+
+  s->cumulativeStatistics->perfCountersOn = TRUE;
+}
+
+Bool_t GC_perfCountersEnabled(GC_state s) {
+  return s->controls->perfCounters;
+}
+
+uint64_t GC_getPerfCountOfProc(
+  GC_state s,
+  uint32_t proc,
+  uint32_t phase,
+  uint32_t event)
+{
+  if (phase >= PERF_NUM_PHASES || event >= GC_PERF_NUM_EVENTS)
+    return 0;
+
+  GC_state ps = &(s->procStates[proc]);
+  uint64_t mutator[GC_PERF_NUM_EVENTS];
+  if (PERF_PHASE_MUTATOR == phase && computePerfCountsMutator(ps, mutator, NULL))
+    return mutator[event];
+  return ps->cumulativeStatistics->perfCounts[phase][event];
+}
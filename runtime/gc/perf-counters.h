@@ -0,0 +1,87 @@
+/* MLton is released under a HPND-style license.
+ * See the file MLton-LICENSE for details.
+ */
+
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+/* hardware events, as numbered for GC_perfCounterOpen */
+#define GC_PERF_CYCLES 0
+#define GC_PERF_INSTRUCTIONS 1
+#define GC_PERF_CACHE_MISSES 2
+#define GC_PERF_DTLB_MISSES 3
+#define GC_PERF_NUM_EVENTS 4
+
+#if (defined (MLTON_GC_INTERNAL_TYPES))
+
+/* With `@mpl perf-counters --`, each processor counts cycles, instructions,
+ * cache misses and dTLB load misses of its own thread, and attributes them
+ * to the phase it is in. MUTATOR is everything outside of the other phases,
+ * including the scheduler.
+ */
+enum PerfCounterPhase {
+  PERF_PHASE_LOCAL_GC,
+  PERF_PHASE_CC,
+  PERF_PHASE_PROMOTION,
+  PERF_PHASE_MUTATOR,
+  PERF_NUM_PHASES
+};
+
+struct PerfCounterSample {
+  uint64_t values[GC_PERF_NUM_EVENTS];
+};
+
+struct PerfCounters {
+  /* leader of the counter group, or -1 if counting is off */
+  int leaderFd;
+  uint32_t numOpen;
+  int fds[GC_PERF_NUM_EVENTS];
+  /* the GC_PERF_* event of each open counter, in group order */
+  uint32_t events[GC_PERF_NUM_EVENTS];
+  /* phases don't nest; a phase started within another is not sampled */
+  bool inPhase;
+  /* whether the kernel has multiplexed the group, which is reported once */
+  bool multiplexed;
+};
+
+#endif /* (defined (MLTON_GC_INTERNAL_TYPES)) */
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+void initPerfCounters(struct PerfCounters *pc);
+
+/* Take a sample at the start of a phase. Returns FALSE (and nothing need be
+ * passed to endPerfCounterPhase) if counting is off or already in a phase.
+ */
+bool beginPerfCounterPhase(GC_state s, struct PerfCounterSample *start);
+void endPerfCounterPhase(
+  GC_state s,
+  enum PerfCounterPhase phase,
+  struct PerfCounterSample *start);
+
+/* Recompute the MUTATOR counts of s from its running totals. Only the
+ * processor of s may call this, since it writes the statistics of s. */
+void updatePerfCountersMutator(GC_state s);
+
+/* Record the final MUTATOR counts of s, and close its counters. Called by
+ * each processor as it terminates (and in GC_done). */
+void closePerfCounters(GC_state s);
+
+#endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
+
+#if (defined (MLTON_GC_INTERNAL_BASIS))
+
+/* Open the counters of the calling thread, if enabled. Called once on each
+ * processor's own thread, before it runs any ML code. */
+PRIVATE void GC_perfCountersThreadInit(GC_state s);
+
+PRIVATE Bool_t GC_perfCountersEnabled(GC_state s);
+PRIVATE uint64_t GC_getPerfCountOfProc(
+  GC_state s,
+  uint32_t proc,
+  uint32_t phase,
+  uint32_t event);
+
+#endif /* (defined (MLTON_GC_INTERNAL_BASIS)) */
+
+#endif /* PERF_COUNTERS_H_ */
@@ -170,11 +170,17 @@ bool tryUnpinWithDepth(objptr op, uint32_t opDepth) {
 
   pointer p = objptrToPointer(op, NULL);
   GC_header header = getHeader(p);
+
+  /* During a parallel collection, another processor might have forwarded
+   * the object since the caller looked at it. */
+  if (pinType(header) == PIN_NONE)
+    return false;
+
   uint32_t d = unpinDepthOfH(header);
 
   if (d >= opDepth) {
     GC_header newHeader =
-        getHeader(p)
+        header
       & (~UNPIN_DEPTH_MASK)  // clear counter bits
       & (~PIN_MASK);         // clear mark bit
 
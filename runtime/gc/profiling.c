@@ -33,9 +33,14 @@ const char * profileIndexSourceName (GC_state s, GC_sourceIndex i) {
   return res;
 }
 
-GC_profileStack getProfileStackInfo (GC_state s, GC_profileMasterIndex i) {
+GC_profileBuffer getProfileBuffer (GC_state s) {
   assert (s->profiling.data != NULL);
-  return &(s->profiling.data->stack[i]);
+  assert ((uint32_t)s->procNumber < s->profiling.data->numberOfProcs);
+  return s->profiling.data->buffers[s->procNumber];
+}
+
+GC_profileStack getProfileStackInfo (GC_state s, GC_profileMasterIndex i) {
+  return &(getProfileBuffer (s)->stack[i]);
 }
 
 static int profileDepth = 0;
@@ -48,10 +53,10 @@ static void profileIndent (void) {
 }
 
 void addToStackForProfiling (GC_state s, GC_profileMasterIndex i) {
-  GC_profileData p;
+  GC_profileBuffer p;
   GC_profileStack ps;
 
-  p = s->profiling.data;
+  p = getProfileBuffer (s);
   ps = getProfileStackInfo (s, i);
   if (DEBUG_PROFILE)
     fprintf (stderr, "adding %s to stack  lastTotal = %"PRIuMAX"  lastTotalGC = %"PRIuMAX"\n",
@@ -108,12 +113,12 @@ void GC_profileEnter (GC_state s) {
   enterForProfiling (s, getCachedStackTopFrameSourceSeqIndex (s));
 }
 
-void removeFromStackForProfiling (GC_state s, GC_profileMasterIndex i) {
-  GC_profileData p;
+static void removeFromBufferStackForProfiling (GC_state s,
+                                               GC_profileBuffer p,
+                                               GC_profileMasterIndex i) {
   GC_profileStack ps;
 
-  p = s->profiling.data;
-  ps = getProfileStackInfo (s, i);
+  ps = &(p->stack[i]);
   if (DEBUG_PROFILE)
     fprintf (stderr, "removing %s from stack  ticksInc = %"PRIuMAX"  ticksGCInc = %"PRIuMAX"\n",
              profileIndexSourceName (s, i),
@@ -123,11 +128,20 @@ void removeFromStackForProfiling (GC_state s, GC_profileMasterIndex i) {
   ps->ticksGC += p->totalGC - ps->lastTotalGC;
 }
 
+void removeFromStackForProfiling (GC_state s, GC_profileMasterIndex i) {
+  removeFromBufferStackForProfiling (s, getProfileBuffer (s), i);
+}
+
 void leaveSourceForProfiling (GC_state s, GC_profileMasterIndex i) {
   GC_profileStack ps;
 
   ps = getProfileStackInfo (s, i);
-  assert (ps->numOccurrences > 0);
+  /* A thread that was suspended and resumed on another processor leaves
+   * functions that it entered elsewhere; those occurrences are closed on
+   * their original processor by GC_profileDone.
+   */
+  if (0 == ps->numOccurrences)
+    return;
   ps->numOccurrences--;
   if (0 == ps->numOccurrences)
     removeFromStackForProfiling (s, i);
@@ -164,6 +178,7 @@ void GC_profileLeave (GC_state s) {
 void incForProfiling (GC_state s, size_t amount, GC_sourceSeqIndex sourceSeqIndex) {
   const uint32_t *sourceSeq;
   GC_sourceIndex topSourceIndex;
+  GC_profileBuffer p;
 
   if (DEBUG_PROFILE)
     fprintf (stderr, "incForProfiling (%"PRIuMAX", "FMTSSI")\n",
@@ -179,14 +194,15 @@ void incForProfiling (GC_state s, size_t amount, GC_sourceSeqIndex sourceSeqInde
     fprintf (stderr, "bumping %s by %"PRIuMAX"\n",
              getSourceName (s, topSourceIndex), (uintmax_t)amount);
   }
-  s->profiling.data->countTop[topSourceIndex] += amount;
-  s->profiling.data->countTop[sourceIndexToProfileMasterIndex (s, topSourceIndex)] += amount;
+  p = getProfileBuffer (s);
+  p->countTop[topSourceIndex] += amount;
+  p->countTop[sourceIndexToProfileMasterIndex (s, topSourceIndex)] += amount;
   if (s->profiling.stack)
     enterForProfiling (s, sourceSeqIndex);
   if (GC_SOURCE_INDEX == topSourceIndex)
-    s->profiling.data->totalGC += amount;
+    p->totalGC += amount;
   else
-    s->profiling.data->total += amount;
+    p->total += amount;
   if (s->profiling.stack)
     leaveForProfiling (s, sourceSeqIndex);
 }
@@ -214,11 +230,11 @@ void GC_profileAllocInc (GC_state s, size_t amount) {
   }
 }
 
-GC_profileData profileMalloc (GC_state s) {
-  GC_profileData p;
+static GC_profileBuffer profileBufferMalloc (GC_state s) {
+  GC_profileBuffer p;
   uint32_t profileMasterLength;
 
-  p = (GC_profileData)(malloc_safe (sizeof(*p)));
+  p = (GC_profileBuffer)(malloc_safe (sizeof(*p)));
   p->total = 0;
   p->totalGC = 0;
   profileMasterLength = s->sourceMaps.sourcesLength + s->sourceMaps.sourceNamesLength;
@@ -227,6 +243,30 @@ GC_profileData profileMalloc (GC_state s) {
     p->stack =
       (struct GC_profileStack *)
       (calloc_safe(profileMasterLength, sizeof(*(p->stack))));
+  else
+    p->stack = NULL;
+  return p;
+}
+
+static void profileBufferFree (GC_state s, GC_profileBuffer p) {
+  free (p->countTop);
+  if (s->profiling.stack)
+    free (p->stack);
+  free (p);
+}
+
+GC_profileData profileMalloc (GC_state s) {
+  GC_profileData p;
+
+  p = (GC_profileData)(malloc_safe (sizeof(*p)));
+  p->numberOfProcs = s->numberOfProcs;
+  /* Each buffer is a separate allocation, so that processors do not share
+   * cache lines when bumping their totals.
+   */
+  p->buffers =
+    (GC_profileBuffer *)(calloc_safe(p->numberOfProcs, sizeof(*(p->buffers))));
+  for (uint32_t proc = 0; proc < p->numberOfProcs; proc++)
+    p->buffers[proc] = profileBufferMalloc (s);
   if (DEBUG_PROFILE)
     fprintf (stderr, FMTPTR" = profileMalloc ()\n", (uintptr_t)p);
   return p;
@@ -239,9 +279,9 @@ GC_profileData GC_profileMalloc (GC_state s) {
 void profileFree (GC_state s, GC_profileData p) {
   if (DEBUG_PROFILE)
     fprintf (stderr, "profileFree ("FMTPTR")\n", (uintptr_t)p);
-  free (p->countTop);
-  if (s->profiling.stack)
-    free (p->stack);
+  for (uint32_t proc = 0; proc < p->numberOfProcs; proc++)
+    profileBufferFree (s, p->buffers[proc]);
+  free (p->buffers);
   free (p);
 }
 
@@ -250,12 +290,12 @@ void GC_profileFree (GC_state s, GC_profileData p) {
 }
 
 void writeProfileCount (GC_state s, FILE *f,
-                        GC_profileData p, GC_profileMasterIndex i) {
-  writeUintmaxU (f, p->countTop[i]);
+                        GC_profileBuffer b, GC_profileMasterIndex i) {
+  writeUintmaxU (f, b->countTop[i]);
   if (s->profiling.stack) {
     GC_profileStack ps;
 
-    ps = &(p->stack[i]);
+    ps = &(b->stack[i]);
     writeString (f, " ");
     writeUintmaxU (f, ps->ticks);
     writeString (f, " ");
@@ -264,12 +304,73 @@ void writeProfileCount (GC_state s, FILE *f,
   writeNewline (f);
 }
 
+/* The per-processor section follows the sections that mlprof has always
+ * read, so older readers still see the merged profile.  It is
+ *
+ *   procs <numberOfProcs>
+ * and then, for each processor,
+ *   <proc> <total> <totalGC> <n>
+ *   n lines of <index> <countTop[index]>, for the nonzero entries only
+ *
+ * where total counts mutator ticks and totalGC counts ticks in the GC.
+ */
+void writeProfileProcs (GC_state s, FILE *f, GC_profileData p) {
+  uint32_t profileMasterLength =
+    s->sourceMaps.sourcesLength + s->sourceMaps.sourceNamesLength;
+
+  writeString (f, "procs ");
+  writeUint32U (f, p->numberOfProcs);
+  writeNewline (f);
+  for (uint32_t proc = 0; proc < p->numberOfProcs; proc++) {
+    GC_profileBuffer b = p->buffers[proc];
+    uint32_t numNonZero = 0;
+
+    for (GC_profileMasterIndex i = 0; i < profileMasterLength; i++)
+      if (0 != b->countTop[i])
+        numNonZero++;
+    writeUint32U (f, proc);
+    writeString (f, " ");
+    writeUintmaxU (f, b->total);
+    writeString (f, " ");
+    writeUintmaxU (f, b->totalGC);
+    writeString (f, " ");
+    writeUint32U (f, numNonZero);
+    writeNewline (f);
+    for (GC_profileMasterIndex i = 0; i < profileMasterLength; i++) {
+      if (0 == b->countTop[i])
+        continue;
+      writeUint32U (f, i);
+      writeString (f, " ");
+      writeUintmaxU (f, b->countTop[i]);
+      writeNewline (f);
+    }
+  }
+}
+
 void profileWrite (GC_state s, GC_profileData p, const char *fileName) {
   FILE *f;
   const char* kind;
+  GC_profileBuffer merged;
+  uint32_t profileMasterLength;
 
   if (DEBUG_PROFILE)
     fprintf (stderr, "profileWrite("FMTPTR",%s)\n", (uintptr_t)p, fileName);
+  profileMasterLength =
+    s->sourceMaps.sourcesLength + s->sourceMaps.sourceNamesLength;
+  merged = profileBufferMalloc (s);
+  for (uint32_t proc = 0; proc < p->numberOfProcs; proc++) {
+    GC_profileBuffer b = p->buffers[proc];
+
+    merged->total += b->total;
+    merged->totalGC += b->totalGC;
+    for (GC_profileMasterIndex i = 0; i < profileMasterLength; i++) {
+      merged->countTop[i] += b->countTop[i];
+      if (s->profiling.stack) {
+        merged->stack[i].ticks += b->stack[i].ticks;
+        merged->stack[i].ticksGC += b->stack[i].ticksGC;
+      }
+    }
+  }
   f = fopen_safe (fileName, "wb");
   writeString (f, "MLton prof\n");
   switch (s->profiling.kind) {
@@ -293,28 +394,61 @@ void profileWrite (GC_state s, GC_profileData p, const char *fileName) {
   writeString (f, s->profiling.stack ? "stack\n" : "current\n");
   writeUint32X (f, s->magic);
   writeNewline (f);
-  writeUintmaxU (f, p->total);
+  writeUintmaxU (f, merged->total);
   writeString (f, " ");
-  writeUintmaxU (f, p->totalGC);
+  writeUintmaxU (f, merged->totalGC);
   writeNewline (f);
   writeUint32U (f, s->sourceMaps.sourcesLength);
   writeNewline (f);
   for (GC_sourceIndex i = 0; i < s->sourceMaps.sourcesLength; i++)
-    writeProfileCount (s, f, p,
+    writeProfileCount (s, f, merged,
                        (GC_profileMasterIndex)i);
   writeUint32U (f, s->sourceMaps.sourceNamesLength);
   writeNewline (f);
   for (GC_sourceNameIndex i = 0; i < s->sourceMaps.sourceNamesLength; i++)
-    writeProfileCount (s, f, p,
+    writeProfileCount (s, f, merged,
                        (GC_profileMasterIndex)(i + s->sourceMaps.sourcesLength));
+  writeProfileProcs (s, f, p);
   fclose_safe (f);
+  profileBufferFree (s, merged);
 }
 
 void GC_profileWrite (GC_state s, GC_profileData p, NullString8_t fileName) {
   profileWrite (s, p, (const char*)fileName);
 }
 
-void setProfTimer (suseconds_t usec) {
+/* The processors sharing s's profiling state: all of them, or just s
+ * itself before the processor states exist (e.g., in a library).
+ */
+static inline uint32_t numProfilingProcs (GC_state s) {
+  return (NULL == s->procStates) ? 1 : s->numberOfProcs;
+}
+
+static inline GC_state getProfilingProc (GC_state s, uint32_t proc) {
+  return (NULL == s->procStates) ? s : &(s->procStates[proc]);
+}
+
+#if HAS_THREAD_CPU_TIMERS
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+void setProfTimer (GC_state s, suseconds_t usec) {
+  struct itimerspec its;
+
+  unless (s->profiling.hasTimer)
+    return;
+  its.it_interval.tv_sec = 0;
+  its.it_interval.tv_nsec = (long)usec * 1000;
+  its.it_value = its.it_interval;
+  unless (0 == timer_settime (s->profiling.timer, 0, &its, NULL))
+    diee ("setProfTimer: timer_settime failed");
+}
+
+#else
+
+void setProfTimer (__attribute__ ((unused)) GC_state s, suseconds_t usec) {
   struct itimerval iv;
 
   iv.it_interval.tv_sec = 0;
@@ -325,6 +459,17 @@ void setProfTimer (suseconds_t usec) {
     die ("setProfTimer: setitimer failed");
 }
 
+#endif
+
+static void setProfTimers (GC_state s, suseconds_t usec) {
+#if HAS_THREAD_CPU_TIMERS
+  for (uint32_t proc = 0; proc < numProfilingProcs (s); proc++)
+    setProfTimer (getProfilingProc (s, proc), usec);
+#else
+  setProfTimer (s, usec);
+#endif
+}
+
 #if not HAS_TIME_PROFILING
 
 /* No time profiling on this platform.  There is a check in
@@ -336,12 +481,21 @@ void initProfilingTime (__attribute__ ((unused)) GC_state s) {
   die ("no time profiling");
 }
 
+void GC_profileThreadInit (__attribute__ ((unused)) GC_state s) {
+}
+
 #else
 
 void GC_handleSigProf (__attribute__ ((unused)) int signum) {
   GC_state s = MLton_gcState ();
   GC_sourceSeqIndex sourceSeqIndex;
 
+  /* Without per-processor timers, the signal may land on a thread that is
+   * not a processor, e.g., the trace writer.
+   */
+  if (NULL == s or not s->profiling.isOn)
+    return;
+
   if (DEBUG_PROFILE)
     fprintf (stderr, "GC_handleSigProf () [%d]\n", Proc_processorNumber (s));
   if (s->amInGC)
@@ -360,12 +514,53 @@ void GC_handleSigProf (__attribute__ ((unused)) int signum) {
 }
 
 void GC_profileDisable (void) {
-  setProfTimer (0);
+  GC_state s = MLton_gcState ();
+
+  if (NULL != s)
+    setProfTimers (s, 0);
 }
 void GC_profileEnable (void) {
-  setProfTimer (10000);
+  GC_state s = MLton_gcState ();
+
+  if (NULL != s)
+    setProfTimers (s, 10000);
+}
+
+#if HAS_THREAD_CPU_TIMERS
+
+/* Each processor samples its own CPU time, rather than sharing one
+ * process-wide ITIMER_PROF whose signal the kernel delivers to an arbitrary
+ * thread.  The timer must be created on the thread it samples.
+ */
+static void startProfTimer (GC_state s) {
+  struct sigevent sev;
+
+  memset (&sev, 0, sizeof (sev));
+  sev.sigev_notify = SIGEV_THREAD_ID;
+  sev.sigev_signo = SIGPROF;
+  sev.sigev_notify_thread_id = (pid_t)(syscall (SYS_gettid));
+  unless (0 == timer_create (CLOCK_THREAD_CPUTIME_ID, &sev, &(s->profiling.timer)))
+    diee ("startProfTimer: timer_create failed");
+  s->profiling.hasTimer = TRUE;
+  setProfTimer (s, 10000);
+}
+
+void GC_profileThreadInit (GC_state s) {
+  if (s->profiling.isOn and PROFILE_TIME == s->profiling.kind)
+    startProfTimer (s);
+}
+
+#else
+
+static void startProfTimer (GC_state s) {
+  setProfTimer (s, 10000);
 }
 
+void GC_profileThreadInit (__attribute__ ((unused)) GC_state s) {
+}
+
+#endif
+
 static void initProfilingTime (GC_state s) {
   struct sigaction sa;
 
@@ -395,8 +590,10 @@ static void initProfilingTime (GC_state s) {
   sa.sa_handler = GC_handleSigProf;
   unless (sigaction (SIGPROF, &sa, NULL) == 0)
     diee ("initProfilingTime: sigaction failed");
-  /* Start the SIGPROF timer. */
-  setProfTimer (10000);
+  /* Start the SIGPROF timer for this processor; the others start theirs in
+   * GC_profileThreadInit.
+   */
+  startProfTimer (s);
 }
 
 #endif
@@ -421,6 +618,9 @@ void atexitForProfiling (void) {
 }
 
 void initProfiling (GC_state s) {
+#if HAS_THREAD_CPU_TIMERS
+  s->profiling.hasTimer = FALSE;
+#endif
   if (PROFILE_NONE == s->profiling.kind)
     s->profiling.isOn = FALSE;
   else {
@@ -444,6 +644,16 @@ void initProfiling (GC_state s) {
   }
 }
 
+void duplicateProfiling (GC_state d, GC_state s) {
+  d->profiling.data = s->profiling.data;
+  d->profiling.isOn = s->profiling.isOn;
+  d->profiling.kind = s->profiling.kind;
+  d->profiling.stack = s->profiling.stack;
+#if HAS_THREAD_CPU_TIMERS
+  d->profiling.hasTimer = FALSE;
+#endif
+}
+
 void GC_profileDone (GC_state s) {
   GC_profileData p;
   GC_profileMasterIndex profileMasterIndex;
@@ -453,20 +663,25 @@ void GC_profileDone (GC_state s) {
              Proc_processorNumber (s));
   assert (s->profiling.isOn);
   if (PROFILE_TIME == s->profiling.kind)
-    setProfTimer (0);
-  s->profiling.isOn = FALSE;
+    setProfTimers (s, 0);
+  for (uint32_t proc = 0; proc < numProfilingProcs (s); proc++)
+    getProfilingProc (s, proc)->profiling.isOn = FALSE;
   p = s->profiling.data;
   if (s->profiling.stack) {
     uint32_t profileMasterLength =
       s->sourceMaps.sourcesLength + s->sourceMaps.sourceNamesLength;
-    for (profileMasterIndex = 0;
-         profileMasterIndex < profileMasterLength;
-         profileMasterIndex++) {
-      if (p->stack[profileMasterIndex].numOccurrences > 0) {
-        if (DEBUG_PROFILE)
-          fprintf (stderr, "done leaving %s\n",
-                   profileIndexSourceName (s, profileMasterIndex));
-        removeFromStackForProfiling (s, profileMasterIndex);
+    for (uint32_t proc = 0; proc < p->numberOfProcs; proc++) {
+      GC_profileBuffer b = p->buffers[proc];
+
+      for (profileMasterIndex = 0;
+           profileMasterIndex < profileMasterLength;
+           profileMasterIndex++) {
+        if (b->stack[profileMasterIndex].numOccurrences > 0) {
+          if (DEBUG_PROFILE)
+            fprintf (stderr, "done leaving %s [%"PRIu32"]\n",
+                     profileIndexSourceName (s, profileMasterIndex), proc);
+          removeFromBufferStackForProfiling (s, b, profileMasterIndex);
+        }
       }
     }
   }
@@ -477,5 +692,6 @@ GC_profileData GC_getProfileCurrent (GC_state s) {
   return s->profiling.data;
 }
 void GC_setProfileCurrent (GC_state s, GC_profileData p) {
-  s->profiling.data = p;
+  for (uint32_t proc = 0; proc < numProfilingProcs (s); proc++)
+    getProfilingProc (s, proc)->profiling.data = p;
 }
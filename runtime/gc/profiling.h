@@ -41,15 +41,15 @@ typedef struct GC_profileStack {
 
 typedef uint32_t GC_profileMasterIndex;
 
-/* GC_profileData is used for both time and allocation profiling.
+/* A GC_profileBuffer holds the samples taken on one processor.
  * In the comments below, "ticks" mean clock ticks with time profiling and
  * bytes allocated with allocation profiling.
  *
- * All of the arrays in GC_profileData are of length sourcesLength + sourceNamesLength.
+ * All of the arrays in GC_profileBuffer are of length sourcesLength + sourceNamesLength.
  * The first sourceLength entries are for handling the duplicate copies of
  * functions, and the next sourceNamesLength entries are for the master versions.
  */
-typedef struct GC_profileData {
+typedef struct GC_profileBuffer {
   /* countTop is an array that counts for each function the number of
    * ticks that occurred while the function was on top of the stack.
    */
@@ -62,6 +62,17 @@ typedef struct GC_profileData {
   uintmax_t total;
   /* The total number of GC ticks. */
   uintmax_t totalGC;
+} *GC_profileBuffer;
+
+/* GC_profileData is used for both time and allocation profiling.
+ *
+ * There is one buffer per processor, and a processor only ever updates
+ * its own, so taking a sample needs no synchronization.  The buffers are
+ * merged when the profile is written.
+ */
+typedef struct GC_profileData {
+  uint32_t numberOfProcs;
+  GC_profileBuffer *buffers;
 } *GC_profileData;
 
 struct GC_profiling {
@@ -69,6 +80,11 @@ struct GC_profiling {
   bool isOn;
   GC_profileKind kind;
   bool stack;
+#if HAS_THREAD_CPU_TIMERS
+  /* This processor's CPU-clock timer, for time profiling. */
+  timer_t timer;
+  bool hasTimer;
+#endif
 };
 
 #else
@@ -82,6 +98,7 @@ typedef struct GC_profileData *GC_profileData;
 
 static inline GC_profileMasterIndex sourceIndexToProfileMasterIndex (GC_state s, GC_sourceIndex i);
 static inline GC_sourceNameIndex profileMasterIndexToSourceNameIndex (GC_state s, GC_profileMasterIndex i);
+static inline GC_profileBuffer getProfileBuffer (GC_state s);
 static inline GC_profileStack getProfileStackInfo (GC_state s, GC_profileMasterIndex i);
 
 static inline void addToStackForProfiling (GC_state s, GC_profileMasterIndex i);
@@ -101,17 +118,19 @@ static inline void incForProfiling (GC_state s, size_t amount, GC_sourceSeqIndex
 
 static inline const char * profileIndexSourceName (GC_state s, GC_sourceIndex i);
 
-static void writeProfileCount (GC_state s, FILE *f, GC_profileData p, GC_profileMasterIndex i);
+static void writeProfileCount (GC_state s, FILE *f, GC_profileBuffer b, GC_profileMasterIndex i);
+static void writeProfileProcs (GC_state s, FILE *f, GC_profileData p);
 
 PRIVATE GC_profileData profileMalloc (GC_state s);
 PRIVATE void profileWrite (GC_state s, GC_profileData p, const char* fileName);
 PRIVATE void profileFree (GC_state s, GC_profileData p);
 
 static void GC_handleSigProf ();
-static void setProfTimer (suseconds_t usec);
+static void setProfTimer (GC_state s, suseconds_t usec);
 static void initProfilingTime (GC_state s);
 static void atexitForProfiling (void);
 static void initProfiling (GC_state s);
+static void duplicateProfiling (GC_state d, GC_state s);
 
 #endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
 
@@ -134,4 +153,6 @@ PRIVATE void GC_profileEnable ();
 
 PRIVATE void GC_profileDone (GC_state s);
 
+PRIVATE void GC_profileThreadInit (GC_state s);
+
 #endif /* (defined (MLTON_GC_INTERNAL_BASIS)) */
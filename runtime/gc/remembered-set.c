@@ -18,6 +18,32 @@ void HM_remember(HM_remSet remSet, HM_remembered remElem, bool conc) {
   }
 }
 
+void HM_rememberMany(HM_remSet remSet, HM_remembered elems, size_t count) {
+  HM_chunkList list = &(remSet->private);
+  size_t i = 0;
+  while (i < count) {
+    HM_chunk chunk = HM_getChunkListLastChunk(list);
+    size_t room = (NULL == chunk) ? 0 :
+      HM_getChunkSizePastFrontier(chunk) / sizeof(struct HM_remembered);
+    if (0 == room) {
+      chunk = HM_allocateChunkWithPurpose(
+        list,
+        (count - i) * sizeof(struct HM_remembered),
+        BLOCK_FOR_REMEMBERED_SET);
+      room = HM_getChunkSizePastFrontier(chunk) / sizeof(struct HM_remembered);
+    }
+
+    size_t n = min(room, count - i);
+    pointer frontier = HM_getChunkFrontier(chunk);
+    HM_updateChunkFrontierInList(
+      list,
+      chunk,
+      frontier + n * sizeof(struct HM_remembered));
+    memcpy(frontier, &(elems[i]), n * sizeof(struct HM_remembered));
+    i += n;
+  }
+}
+
 void HM_foreachPrivate(
   GC_state s,
   HM_chunkList chunkList,
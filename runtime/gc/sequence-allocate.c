@@ -75,10 +75,14 @@ pointer allocateSmallSequence(
 }
 
 
+/** A large sequence gets a chunk of its own. If `fresh`, that chunk is a new
+  * mapping whose pages nobody has touched yet, so the mutator threads that
+  * initialize the sequence decide where its pages are placed. */
 pointer allocateLargeSequence(
   GC_state s,
   size_t sequenceSizeAligned,
-  size_t ensureBytesFree)
+  size_t ensureBytesFree,
+  bool fresh)
 {
   assert(sequenceSizeAligned >= s->controls->blockSize / 2);
 
@@ -97,8 +101,25 @@ pointer allocateLargeSequence(
   GC_thread thread = getThreadCurrent(s);
   HM_chunk prevChunk = thread->currentChunk;
 
-  if (!HM_HH_extend(s, thread, sequenceSizeAligned)) {
-    DIE("Ran out of space!");
+  if (!HM_HH_tryExtend(s, thread, sequenceSizeAligned, fresh)) {
+    /** Past max-heap. Nothing points into the sequence yet, so we can still
+      * collect and try again (see HM_extendHeapWithinLimit), as long as we
+      * redo the assurances for the chunk we come back to afterwards.
+      */
+    HM_collectForHeapLimit(s);
+    HM_ensureHierarchicalHeapAssurances(s, FALSE, ensureBytesFree, TRUE);
+    thread = getThreadCurrent(s);
+    prevChunk = thread->currentChunk;
+
+    if (!HM_HH_tryExtend(s, thread, sequenceSizeAligned, fresh)) {
+      setHeapLimitExceeded(s);
+      bool extended =
+        fresh ? HM_HH_extendFresh(s, thread, sequenceSizeAligned)
+              : HM_HH_extend(s, thread, sequenceSizeAligned);
+      if (!extended) {
+        DIE("Ran out of space!");
+      }
+    }
   }
 
   pointer result = HM_HH_getFrontier(thread);
@@ -181,8 +202,17 @@ pointer GC_sequenceAllocate (GC_state s,
 
   if (sequenceSizeAligned < s->controls->blockSize / 2)
     frontier = allocateSmallSequence(s, sequenceSizeAligned, ensureBytesFree);
-  else
-    frontier = allocateLargeSequence(s, sequenceSizeAligned, ensureBytesFree);
+  else {
+    /* Only the metadata of a sequence without objptrs is written here, so
+     * a huge one can be left entirely to first-touch. */
+    bool fresh =
+      0 == numObjptrs
+      && 0 < s->controls->freshSequenceMinSize
+      && sequenceSizeAligned >= s->controls->freshSequenceMinSize;
+    frontier =
+      allocateLargeSequence(s, sequenceSizeAligned, ensureBytesFree, fresh);
+    HM_getChunkOf(frontier)->noObjptrs = (0 == numObjptrs);
+  }
 
   result = sequenceInitialize(s,
                               frontier,
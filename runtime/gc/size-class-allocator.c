@@ -0,0 +1,52 @@
+/* MLton is released under a HPND-style license.
+ * See the file MLton-LICENSE for details.
+ */
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+void initSizeClassAllocator(SizeClassAllocator sca, enum BlockPurpose purpose) {
+  for (uint32_t i = 0; i < METADATA_NUM_SIZE_CLASSES; i++) {
+    size_t size = (size_t)1 << (METADATA_MIN_SIZE_BITS + i);
+    initFixedSizeAllocator(&(sca->classes[i]), size, purpose);
+  }
+}
+
+
+static inline uint32_t metadataSizeClass(size_t bytes) {
+  assert(0 < bytes && bytes <= METADATA_MAX_SIZE);
+  if (bytes <= ((size_t)1 << METADATA_MIN_SIZE_BITS))
+    return 0;
+
+  /* ceil(log2(bytes)) - METADATA_MIN_SIZE_BITS */
+  uint32_t log2 =
+    (uint32_t)(CHAR_BIT * sizeof(unsigned long))
+    - (uint32_t)__builtin_clzl((unsigned long)(bytes - 1));
+  return log2 - METADATA_MIN_SIZE_BITS;
+}
+
+
+void* allocateMetadata(GC_state s, size_t bytes) {
+  if (bytes > METADATA_MAX_SIZE)
+    return malloc_safe(bytes);
+
+  SizeClassAllocator sca = getMetadataAllocator(s);
+  FixedSizeAllocator fsa = &(sca->classes[metadataSizeClass(bytes)]);
+  assert(fsa->fixedSize >= bytes);
+  return allocateFixedSize(fsa);
+}
+
+
+void freeMetadata(GC_state s, void* p, size_t bytes) {
+  if (NULL == p)
+    return;
+
+  if (bytes > METADATA_MAX_SIZE) {
+    free(p);
+    return;
+  }
+
+  SizeClassAllocator sca = getMetadataAllocator(s);
+  freeFixedSize(&(sca->classes[metadataSizeClass(bytes)]), p);
+}
+
+#endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
@@ -0,0 +1,53 @@
+/* MLton is released under a HPND-style license.
+ * See the file MLton-LICENSE for details.
+ */
+
+#ifndef SIZE_CLASS_ALLOCATOR_H_
+#define SIZE_CLASS_ALLOCATOR_H_
+
+#if (defined (MLTON_GC_INTERNAL_TYPES))
+
+/* Small runtime-internal objects (e.g. the snapshot stacks of concurrent
+ * collections) are allocated from per-processor slabs, segregated by size
+ * into power-of-two classes from 2^METADATA_MIN_SIZE_BITS up to
+ * METADATA_MAX_SIZE bytes. Each class is a FixedSizeAllocator, so a
+ * processor allocates from and frees to its own free-list without
+ * synchronization, and objects freed by another processor go back to their
+ * owner in batches (see freeFixedSize).
+ *
+ * Larger requests fall back to malloc.
+ */
+#define METADATA_MIN_SIZE_BITS 4
+#define METADATA_NUM_SIZE_CLASSES 8
+#define METADATA_MAX_SIZE \
+  ((size_t)1 << (METADATA_MIN_SIZE_BITS + METADATA_NUM_SIZE_CLASSES - 1))
+
+typedef struct SizeClassAllocator {
+  struct FixedSizeAllocator classes[METADATA_NUM_SIZE_CLASSES];
+} *SizeClassAllocator;
+
+#else
+
+struct SizeClassAllocator;
+typedef struct SizeClassAllocator *SizeClassAllocator;
+
+#endif /* (defined (MLTON_GC_INTERNAL_TYPES)) */
+
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+void initSizeClassAllocator(SizeClassAllocator sca, enum BlockPurpose purpose);
+
+/** Allocate [bytes] of runtime metadata on the current processor. The
+  * result is 8-byte aligned and uninitialized.
+  */
+void* allocateMetadata(GC_state s, size_t bytes);
+
+/** Free [p], which must have been returned by allocateMetadata with the same
+  * [bytes]. Any processor may free it.
+  */
+void freeMetadata(GC_state s, void* p, size_t bytes);
+
+#endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
+
+#endif /* SIZE_CLASS_ALLOCATOR_H_ */
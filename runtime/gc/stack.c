@@ -235,3 +235,18 @@ void copyStack (GC_state s, GC_stack from, GC_stack to) {
              (uintmax_t)from->used);
   GC_memcpy (fromBottom, toBottom, from->used);
 }
+
+/* Give the pages of a stack that are above its top back to the OS. They
+ * stay mapped and read as zeros if the stack grows into them again. Only
+ * worth the system call for stacks in a chunk with a reserved tail (see
+ * HM_reserveChunkTail), which is already uncommitted.
+ */
+void releaseStackUnused (GC_state s, GC_stack stack) {
+  size_t pageSize = GC_pageSize ();
+  pointer top = (pointer)align ((size_t)getStackTop (s, stack), pageSize);
+  pointer end =
+    (pointer)alignDown ((size_t)(getStackBottom (s, stack) + stack->reserved),
+                        pageSize);
+  if (top < end)
+    GC_decommit (top, (size_t)(end - top));
+}
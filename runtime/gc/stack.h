@@ -81,5 +81,6 @@ static inline size_t sizeofStackGrowReserved (GC_state s, GC_stack stack);
 static inline size_t sizeofStackShrinkReserved (GC_state s, GC_stack stack, bool current);
 
 static inline void copyStack (GC_state s, GC_stack from, GC_stack to);
+static void releaseStackUnused (GC_state s, GC_stack stack);
 
 #endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
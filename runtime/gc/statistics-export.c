@@ -0,0 +1,157 @@
+/* MLton is released under a HPND-style license.
+ * See the file MLton-LICENSE for details.
+ */
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+struct StatsExporter {
+  struct GC_statsPage *page;
+  /* guards against two processors sampling at once when an update takes
+   * longer than the interval */
+  volatile uint32_t busy;
+};
+
+
+static inline uint64_t timespecToNanoseconds(struct timespec *tm) {
+  return (uint64_t)tm->tv_sec * 1000000000ULL + (uint64_t)tm->tv_nsec;
+}
+
+
+static void exportProcStatistics(
+  struct GC_statsPageProc *dst,
+  struct GC_cumulativeStatistics *src)
+{
+  dst->bytesAllocated = src->bytesAllocated;
+  dst->bytesPromoted = src->bytesPromoted;
+  dst->bytesInScopeForLocal = src->bytesInScopeForLocal;
+  dst->bytesReclaimedByLocal = src->bytesReclaimedByLocal;
+  dst->bytesInScopeForCC = src->bytesInScopeForCC;
+  dst->bytesReclaimedByCC = src->bytesReclaimedByCC;
+  dst->maxBytesLive = src->maxBytesLive;
+  dst->maxHeapSize = src->maxHeapSize;
+  dst->numHHLocalGCs = src->numHHLocalGCs;
+  dst->numCCs = src->numCCs;
+  dst->timeLocalGC = timespecToNanoseconds(&(src->timeLocalGC));
+  dst->timeLocalPromo = timespecToNanoseconds(&(src->timeLocalPromo));
+  dst->timeCC = timespecToNanoseconds(&(src->timeCC));
+
+  dst->numDisentanglementChecks = src->numDisentanglementChecks;
+  dst->numEntanglements = src->numEntanglements;
+  dst->numChecksSkipped = src->numChecksSkipped;
+  dst->numSuspectsMarked = src->numSuspectsMarked;
+  dst->numSuspectsCleared = src->numSuspectsCleared;
+  dst->bytesPinnedEntangled = src->bytesPinnedEntangled;
+  dst->bytesPinnedEntangledWatermark = src->bytesPinnedEntangledWatermark;
+
+  dst->numJoinMerges = src->numJoinMerges;
+  dst->numJoinPromotions = src->numJoinPromotions;
+  dst->numJoinLevelsSpliced = src->numJoinLevelsSpliced;
+  dst->timeJoinMerge = timespecToNanoseconds(&(src->timeJoinMerge));
+  dst->timeJoinPromote = timespecToNanoseconds(&(src->timeJoinPromote));
+  dst->numCCSlices = src->numCCSlices;
+}
+
+
+void exportStatistics(GC_state s, struct timespec *now, void *env) {
+  struct StatsExporter *exp = env;
+  struct GC_statsPage *page = exp->page;
+
+  if (!__sync_bool_compare_and_swap(&(exp->busy), 0, 1))
+    return;
+
+  size_t mapped;
+  size_t globalMapped;
+  size_t released;
+  size_t globalReleased;
+  size_t allocated[NUM_BLOCK_PURPOSES];
+  size_t freed[NUM_BLOCK_PURPOSES];
+  queryCurrentBlockUsage(
+    s,
+    &mapped,
+    &globalMapped,
+    &released,
+    &globalReleased,
+    (size_t*)allocated,
+    (size_t*)freed
+  );
+
+  struct timespec wallClock;
+  clock_gettime(CLOCK_REALTIME, &wallClock);
+
+  __atomic_store_n(&(page->sequence), page->sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  page->numUpdates++;
+  page->timeSinceStart = timespecToNanoseconds(now);
+  page->wallClockSec = wallClock.tv_sec;
+  page->wallClockNsec = wallClock.tv_nsec;
+
+  page->numBlocksMapped = mapped;
+  page->numBlocksReleased = released;
+  page->numGlobalBlocksMapped = globalMapped;
+  page->numGlobalBlocksReleased = globalReleased;
+  for (enum BlockPurpose p = 0; p < NUM_BLOCK_PURPOSES; p++) {
+    page->numBlocksAllocated[p] = allocated[p];
+    page->numBlocksFreed[p] = freed[p];
+  }
+
+  for (uint32_t i = 0; i < s->numberOfProcs; i++) {
+    exportProcStatistics(
+      &(page->procs[i]),
+      s->procStates[i].cumulativeStatistics);
+  }
+
+  __atomic_store_n(&(page->sequence), page->sequence + 1, __ATOMIC_RELEASE);
+
+  __sync_synchronize();
+  exp->busy = 0;
+}
+
+
+Sampler newStatsExportSampler(GC_state s) {
+  const char *path = s->controls->statsFile;
+  if (NULL == path)
+    return NULL;
+
+  size_t bytes =
+    sizeof(struct GC_statsPage)
+    + s->numberOfProcs * sizeof(struct GC_statsPageProc);
+  bytes = align(bytes, GC_pageSize());
+
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    die("Unable to open gc-stats-file %s (%s).", path, strerror(errno));
+  if (0 != ftruncate(fd, bytes))
+    die("Unable to size gc-stats-file %s (%s).", path, strerror(errno));
+
+  void *mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (MAP_FAILED == mem)
+    die("Unable to map gc-stats-file %s (%s).", path, strerror(errno));
+  close(fd);
+
+  struct GC_statsPage *page = mem;
+  page->version = GC_STATS_PAGE_VERSION;
+  page->numberOfProcs = s->numberOfProcs;
+  page->numBlockPurposes = NUM_BLOCK_PURPOSES;
+  page->blockSize = s->controls->blockSize;
+  page->sequence = 0;
+  page->numUpdates = 0;
+  /* publish the magic last, so that a reader never sees a partial header */
+  __atomic_store_n(&(page->magic), GC_STATS_PAGE_MAGIC, __ATOMIC_RELEASE);
+
+  struct StatsExporter *exp = malloc(sizeof(struct StatsExporter));
+  exp->page = page;
+  exp->busy = 0;
+
+  struct SamplerClosure func;
+  func.fun = exportStatistics;
+  func.env = exp;
+
+  struct timespec desiredInterval = s->controls->statsExportInterval;
+  Sampler result = malloc(sizeof(struct Sampler));
+  initSampler(s, result, &func, &desiredInterval);
+
+  return result;
+}
+
+#endif /* MLTON_GC_INTERNAL_FUNCS */
@@ -0,0 +1,98 @@
+/* MLton is released under a HPND-style license.
+ * See the file MLton-LICENSE for details.
+ */
+
+#ifndef STATISTICS_EXPORT_H_
+#define STATISTICS_EXPORT_H_
+
+#if (defined (MLTON_GC_INTERNAL_TYPES))
+
+/* Live statistics, published with @mpl gc-stats-file <path> --.
+ *
+ * The file holds a GC_statsPage followed by numberOfProcs GC_statsPageProc
+ * entries, and is rewritten in place (MAP_SHARED) every gc-stats-interval
+ * by whichever processor first enters the runtime after the interval
+ * elapses. Readers mmap the file read-only and never interact with the
+ * program. To get a consistent snapshot, a reader copies the page while
+ * `sequence` is even and unchanged before and after the copy (a seqlock).
+ *
+ * All fields are 64-bit, in native byte order. Counters are cumulative
+ * since program start, and times are in nanoseconds. The per-processor
+ * counters are read without synchronizing with their owners, so each one is
+ * accurate but they may be skewed slightly relative to one another.
+ */
+
+#define GC_STATS_PAGE_MAGIC 0x53544154534c504dULL /* "MPLSTATS" in little-endian */
+#define GC_STATS_PAGE_VERSION 4
+
+struct GC_statsPageProc {
+  uint64_t bytesAllocated;
+  uint64_t bytesPromoted;
+  uint64_t bytesInScopeForLocal;
+  uint64_t bytesReclaimedByLocal;
+  uint64_t bytesInScopeForCC;
+  uint64_t bytesReclaimedByCC;
+  uint64_t maxBytesLive;
+  uint64_t maxHeapSize;
+  uint64_t numHHLocalGCs;
+  uint64_t numCCs;
+  uint64_t timeLocalGC;
+  uint64_t timeLocalPromo;
+  uint64_t timeCC;
+
+  /* entanglement */
+  uint64_t numDisentanglementChecks;
+  uint64_t numEntanglements;
+  uint64_t numChecksSkipped;
+  uint64_t numSuspectsMarked;
+  uint64_t numSuspectsCleared;
+  uint64_t bytesPinnedEntangled;
+  uint64_t bytesPinnedEntangledWatermark;
+
+  /* joins (since version 2) */
+  uint64_t numJoinMerges;
+  uint64_t numJoinPromotions;
+  uint64_t numJoinLevelsSpliced;
+  uint64_t timeJoinMerge;
+  uint64_t timeJoinPromote;
+
+  /* sliced root collections (since version 4) */
+  uint64_t numCCSlices;
+};
+
+struct GC_statsPage {
+  uint64_t magic;
+  uint64_t version;
+  uint64_t numberOfProcs;
+  uint64_t numBlockPurposes;
+  uint64_t blockSize;
+
+  /* odd while an update is in progress */
+  uint64_t sequence;
+  uint64_t numUpdates;
+  uint64_t timeSinceStart;
+  uint64_t wallClockSec;
+  uint64_t wallClockNsec;
+
+  /* block allocator; see queryCurrentBlockUsage */
+  uint64_t numBlocksMapped;
+  uint64_t numBlocksReleased;
+  uint64_t numGlobalBlocksMapped;
+  uint64_t numGlobalBlocksReleased;
+  uint64_t numBlocksAllocated[NUM_BLOCK_PURPOSES];
+  uint64_t numBlocksFreed[NUM_BLOCK_PURPOSES];
+
+  struct GC_statsPageProc procs[];
+};
+
+#endif /* MLTON_GC_INTERNAL_TYPES */
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+/** Map the stats file and return a sampler that refreshes it, or NULL if
+  * gc-stats-file was not given. */
+Sampler newStatsExportSampler(GC_state s);
+
+#endif /* MLTON_GC_INTERNAL_FUNCS */
+
+#endif /* STATISTICS_EXPORT_H_ */
@@ -19,6 +19,9 @@ void outputSyncStatisticsJSON(FILE* out,
                               const char* type,
                               uintmax_t num);
 
+void outputPerfCountersJSON(FILE* out,
+                            struct GC_cumulativeStatistics* statistics);
+
 /************************/
 /* Function Definitions */
 /************************/
@@ -69,6 +72,10 @@ struct GC_cumulativeStatistics *newCumulativeStatistics(void) {
   cumulativeStatistics->numMinorGCs = 0;
   cumulativeStatistics->numHHLocalGCs = 0;
   cumulativeStatistics->numCCs = 0;
+  cumulativeStatistics->numCCSlices = 0;
+  cumulativeStatistics->numJoinMerges = 0;
+  cumulativeStatistics->numJoinPromotions = 0;
+  cumulativeStatistics->numJoinLevelsSpliced = 0;
   cumulativeStatistics->numDisentanglementChecks = 0;
   cumulativeStatistics->numEntanglements = 0;
   cumulativeStatistics->numChecksSkipped = 0;
@@ -85,6 +92,14 @@ struct GC_cumulativeStatistics *newCumulativeStatistics(void) {
   cumulativeStatistics->timeLocalPromo.tv_nsec = 0;
   cumulativeStatistics->timeCC.tv_sec = 0;
   cumulativeStatistics->timeCC.tv_nsec = 0;
+  cumulativeStatistics->timeJoinMerge.tv_sec = 0;
+  cumulativeStatistics->timeJoinMerge.tv_nsec = 0;
+  cumulativeStatistics->timeJoinPromote.tv_sec = 0;
+  cumulativeStatistics->timeJoinPromote.tv_nsec = 0;
+
+  cumulativeStatistics->perfCountersOn = FALSE;
+  memset(cumulativeStatistics->perfCounts, 0,
+         sizeof(cumulativeStatistics->perfCounts));
 
   rusageZero (&cumulativeStatistics->ru_gc);
   rusageZero (&cumulativeStatistics->ru_gcCopying);
@@ -261,6 +276,11 @@ void S_outputCumulativeStatisticsJSON(
     fprintf(out, ", ");
 
     fprintf(out, "\"bytesHashConsed\" : %"PRIuMAX, statistics->bytesHashConsed);
+
+    if (statistics->perfCountersOn) {
+      fprintf(out, ", ");
+      outputPerfCountersJSON(out, statistics);
+    }
   }
   fprintf(out, " }");
 }
@@ -269,6 +289,40 @@ void S_outputCumulativeStatisticsJSON(
 /* Static Function Definitions */
 /*******************************/
 
+static const char* perfPhaseNames[PERF_NUM_PHASES] = {
+  "localGC",
+  "cc",
+  "promotion",
+  "mutator"
+};
+
+static const char* perfEventNames[GC_PERF_NUM_EVENTS] = {
+  "cycles",
+  "instructions",
+  "cacheMisses",
+  "dtlbMisses"
+};
+
+void outputPerfCountersJSON(FILE* out,
+                            struct GC_cumulativeStatistics* statistics) {
+  fprintf(out, "\"perfCounters\" : { ");
+  for (uint32_t phase = 0; phase < PERF_NUM_PHASES; phase++) {
+    if (phase > 0)
+      fprintf(out, ", ");
+    fprintf(out, "\"%s\" : { ", perfPhaseNames[phase]);
+    for (uint32_t e = 0; e < GC_PERF_NUM_EVENTS; e++) {
+      if (e > 0)
+        fprintf(out, ", ");
+      fprintf(out,
+              "\"%s\" : %"PRIu64,
+              perfEventNames[e],
+              statistics->perfCounts[phase][e]);
+    }
+    fprintf(out, " }");
+  }
+  fprintf(out, " }");
+}
+
 void outputCollectionStatisticsJSON(FILE* out,
                                     const char *type,
                                     struct rusage *ru,
@@ -65,6 +65,10 @@ struct GC_cumulativeStatistics {
   uintmax_t numMinorGCs;
   uintmax_t numHHLocalGCs;
   uintmax_t numCCs;
+  uintmax_t numCCSlices;       // slices of root collections (>= numCCs)
+  uintmax_t numJoinMerges;     // heaps merged at joins (HM_HH_merge)
+  uintmax_t numJoinPromotions; // leaf heaps promoted at joins
+  uintmax_t numJoinLevelsSpliced;
   uintmax_t numDisentanglementChecks; // count full read barriers
   uintmax_t numEntanglements;         // count instances entanglement is detected
   uintmax_t numChecksSkipped;
@@ -80,6 +84,14 @@ struct GC_cumulativeStatistics {
 
   struct timespec timeCC;
 
+  struct timespec timeJoinMerge;
+  struct timespec timeJoinPromote;
+
+  /* hardware counters by phase (see perf-counters.h); all zero unless
+   * perfCountersOn */
+  bool perfCountersOn;
+  uint64_t perfCounts[PERF_NUM_PHASES][GC_PERF_NUM_EVENTS];
+
   struct rusage ru_gc; /* total resource usage in gc. */
   struct rusage ru_gcCopying; /* resource usage in major copying gcs. */
   struct rusage ru_gcMarkCompact; /* resource usage in major mark-compact gcs. */
@@ -66,6 +66,11 @@ void GC_switchToThread (GC_state s, pointer p, size_t ensureBytesFree) {
 
   oldCurrentThread->bytesNeeded = ensureBytesFree;
 
+  /* The remember buffer holds entries for the heaps of oldCurrentThread,
+   * which some other processor might pick up as soon as we let go of it. */
+  HM_HH_flushRememberBuffer(s);
+  s->writeBarrierLevelHead = NULL;
+
   s->currentThread = BOGUS_OBJPTR;
   /* SAM_NOTE: This write synchronizes with the spinloop in switchToThread (above) */
   atomicStoreS32(&(oldCurrentThread->currentProcNum), -1);
@@ -18,6 +18,7 @@ uint32_t *pleader(GC_state s) {
 
 void GC_TerminateThread(GC_state s) {
   GC_PthreadAtExit(s);
+  closePerfCounters(s);
   getStackCurrent(s)->used = sizeofGCStateCurrentStackUsed (s);
   getThreadCurrent(s)->exnStack = s->exnStack;
   Trace0(EVENT_RUNTIME_LEAVE);
@@ -77,6 +78,7 @@ bool GC_TryToTerminate(GC_state s) {
   for (uint32_t p = 0; p < s->numberOfProcs; p++)
     if (p != myself)
       s->procStates[p].limit = 0;
+  Parallel_idleWake (s->numberOfProcs);
 
   Trace0(EVENT_HALT_WAIT);
 
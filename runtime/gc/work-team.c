@@ -0,0 +1,171 @@
+#include "work-team.h"
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+void WT_init(
+  struct GC_workTeam *t,
+  size_t sharePeriod,
+  size_t shareBatch,
+  volatile uint32_t *numOpen)
+{
+  t->numHelpers = -1;
+  t->done = FALSE;
+  pthread_mutex_init(&(t->lock), NULL);
+  t->poolSize = 0;
+  t->numActive = 0;
+  t->hasDeadline = FALSE;
+  t->stopping = FALSE;
+  t->sharePeriod = sharePeriod;
+  t->shareBatch = shareBatch;
+  t->numOpen = numOpen;
+}
+
+bool WT_pastDeadline(struct timespec *deadline) {
+  struct timespec now;
+  timespec_now(&now);
+  return now.tv_sec > deadline->tv_sec
+    || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+void WT_open(GC_state s, struct GC_workTeam *t, struct timespec *deadline) {
+  assert(-1 == t->numHelpers);
+
+  t->done = FALSE;
+  t->poolSize = 0;
+  t->numActive = 1;
+  t->hasDeadline = (NULL != deadline);
+  if (NULL != deadline)
+    t->deadline = *deadline;
+  t->stopping = FALSE;
+  CC_workList_init(s, &(t->pool));
+
+  __atomic_store_n(&(t->numHelpers), 0, __ATOMIC_SEQ_CST);
+  __sync_fetch_and_add(t->numOpen, 1);
+  /* parked processors would otherwise only notice after their timeout */
+  Parallel_idleWake(s->numberOfProcs);
+}
+
+bool WT_close(GC_state s, struct GC_workTeam *t, CC_workList worklist) {
+  while (!__sync_bool_compare_and_swap(&(t->numHelpers), 0, -1)) {
+    sched_yield();
+  }
+  __sync_fetch_and_sub(t->numOpen, 1);
+
+  /* only a team that stopped at its deadline leaves work behind */
+  assert(t->stopping || 0 == t->poolSize);
+  while (CC_workList_moveElems(s, &(t->pool), worklist, t->shareBatch) > 0) {}
+  t->poolSize = 0;
+  CC_workList_free(s, &(t->pool));
+  t->hasDeadline = FALSE;
+  t->stopping = FALSE;
+
+  return CC_workList_isEmpty(s, worklist);
+}
+
+bool WT_anyOpen(volatile uint32_t *numOpen) {
+  return 0 != __atomic_load_n(numOpen, __ATOMIC_SEQ_CST);
+}
+
+bool WT_tryJoin(struct GC_workTeam *t) {
+  int32_t numHelpers = __atomic_load_n(&(t->numHelpers), __ATOMIC_SEQ_CST);
+  while (numHelpers >= 0 &&
+         !__sync_bool_compare_and_swap(&(t->numHelpers), numHelpers, numHelpers + 1))
+  {
+    numHelpers = __atomic_load_n(&(t->numHelpers), __ATOMIC_SEQ_CST);
+  }
+  if (numHelpers < 0) {
+    return FALSE;
+  }
+
+  pthread_mutex_lock(&(t->lock));
+  if (t->done) {
+    pthread_mutex_unlock(&(t->lock));
+    __sync_fetch_and_sub(&(t->numHelpers), 1);
+    return FALSE;
+  }
+  t->numActive++;
+  pthread_mutex_unlock(&(t->lock));
+  return TRUE;
+}
+
+void WT_leave(struct GC_workTeam *t) {
+  __sync_fetch_and_sub(&(t->numHelpers), 1);
+}
+
+void WT_drain(
+  GC_state s,
+  struct GC_workTeam *t,
+  CC_workList worklist,
+  GC_workTeamTraceFun trace,
+  void *env)
+{
+  size_t popsSinceCheck = 0;
+
+  while (TRUE) {
+    objptr *field = CC_workList_pop(s, worklist);
+    if (NULL != field) {
+      trace(s, field, env);
+
+      popsSinceCheck++;
+      if (popsSinceCheck >= t->sharePeriod) {
+        popsSinceCheck = 0;
+
+        if (t->hasDeadline && !t->stopping && WT_pastDeadline(&(t->deadline)))
+          t->stopping = TRUE;
+        if (t->stopping) {
+          pthread_mutex_lock(&(t->lock));
+          size_t moved;
+          do {
+            moved = CC_workList_moveElems(s, worklist, &(t->pool), t->shareBatch);
+            t->poolSize += moved;
+          } while (moved > 0);
+          assert(t->numActive > 0);
+          t->numActive--;
+          if (0 == t->numActive)
+            t->done = TRUE;
+          pthread_mutex_unlock(&(t->lock));
+          return;
+        }
+
+        int32_t numHelpers = __atomic_load_n(&(t->numHelpers), __ATOMIC_SEQ_CST);
+        if (0 == t->poolSize && (uint32_t)(numHelpers + 1) > t->numActive) {
+          pthread_mutex_lock(&(t->lock));
+          t->poolSize +=
+            CC_workList_shareElems(s, worklist, &(t->pool), t->shareBatch);
+          pthread_mutex_unlock(&(t->lock));
+        }
+      }
+      continue;
+    }
+
+    /* out of local work. Once stopping, the pool is left for the owner. */
+    pthread_mutex_lock(&(t->lock));
+    while (0 == t->poolSize || t->stopping) {
+      assert(t->numActive > 0);
+      t->numActive--;
+      if (0 == t->numActive) {
+        t->done = TRUE;
+        pthread_mutex_unlock(&(t->lock));
+        return;
+      }
+      pthread_mutex_unlock(&(t->lock));
+
+      while (!t->done && (0 == t->poolSize || t->stopping)) {
+        sched_yield();
+      }
+
+      pthread_mutex_lock(&(t->lock));
+      if (t->done) {
+        pthread_mutex_unlock(&(t->lock));
+        return;
+      }
+      t->numActive++;
+    }
+
+    t->poolSize -=
+      CC_workList_moveElems(s, &(t->pool), worklist, t->shareBatch);
+    pthread_mutex_unlock(&(t->lock));
+  }
+}
+
+#endif /* MLTON_GC_INTERNAL_FUNCS */
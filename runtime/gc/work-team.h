@@ -0,0 +1,90 @@
+#ifndef WORK_TEAM_H
+#define WORK_TEAM_H
+
+#include "cc-work-list.h"
+
+#if (defined (MLTON_GC_INTERNAL_TYPES))
+
+/* A tracing phase (of a local collection, or the mark of a root collection)
+ * which is opened up to idle processors. The owner opens the team, and
+ * helpers join it, each with a worklist of its own. Whoever has plenty of
+ * work shares some of it through the pool whenever fewer workers are busy
+ * than have joined; workers that run dry take from the pool. The phase is
+ * done once every worker is out of work at the same time.
+ *
+ * With a deadline, everyone stops once it has passed and leaves its
+ * unfinished work in the pool, which the owner takes back when it closes
+ * the team.
+ */
+struct GC_workTeam {
+  /* -1 if the team is not accepting helpers; otherwise the number of
+   * helpers that have joined and not yet left. */
+  volatile int32_t numHelpers;
+  volatile bool done;
+
+  /* everything below is protected by the lock */
+  pthread_mutex_t lock;
+  struct CC_workList pool;
+  volatile size_t poolSize;
+  volatile uint32_t numActive;
+
+  bool hasDeadline;
+  struct timespec deadline;
+  volatile bool stopping;
+
+  /* Number of worklist pops between checks for idle workers, and how many
+   * elements to hand off at a time. */
+  size_t sharePeriod;
+  size_t shareBatch;
+
+  /* Counts the open teams of this kind, so that idle processors can skip
+   * looking for one to join when there are none. */
+  volatile uint32_t *numOpen;
+};
+
+/* Traces a single field taken from a worklist. */
+typedef void (*GC_workTeamTraceFun) (GC_state s, objptr *field, void *env);
+
+#endif /* MLTON_GC_INTERNAL_TYPES */
+
+#if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+void WT_init(
+  struct GC_workTeam *t,
+  size_t sharePeriod,
+  size_t shareBatch,
+  volatile uint32_t *numOpen);
+
+/* Owner side. WT_open makes the team visible to helpers (the owner should
+ * already have set up whatever they read once they join) and wakes up parked
+ * processors. WT_close waits for the helpers to leave and moves whatever is
+ * left in the pool back to the worklist; it returns whether the worklist
+ * was drained. */
+void WT_open(GC_state s, struct GC_workTeam *t, struct timespec *deadline);
+bool WT_close(GC_state s, struct GC_workTeam *t, CC_workList worklist);
+
+/* Helper side. Returns whether there is any team of this kind to join. */
+bool WT_anyOpen(volatile uint32_t *numOpen);
+
+/* Returns whether the helper is now a member of the team. It must call
+ * WT_leave when done, after which it may no longer look at the team's
+ * owner. */
+bool WT_tryJoin(struct GC_workTeam *t);
+void WT_leave(struct GC_workTeam *t);
+
+bool WT_pastDeadline(struct timespec *deadline);
+
+/* Trace everything reachable from the worklist with `trace`, sharing with
+ * (and taking from) the pool. Returns when all workers have run out of work,
+ * or have stopped at the deadline. Both the owner and the helpers call
+ * this. */
+void WT_drain(
+  GC_state s,
+  struct GC_workTeam *t,
+  CC_workList worklist,
+  GC_workTeamTraceFun trace,
+  void *env);
+
+#endif /* MLTON_GC_INTERNAL_FUNCS */
+
+#endif /* WORK_TEAM_H */
@@ -7,13 +7,524 @@
  * See the file MLton-LICENSE for details.
  */
 
-__attribute__((noreturn))
-void GC_saveWorld (__attribute__((unused)) GC_state s,
-                   __attribute__((unused)) NullString8_t fileName)
+/* Chunk images with at least this many pages past the first are mapped from
+ * the world file rather than read. Each mapping is a separate VMA, so small
+ * chunks are not worth it. */
+#define WORLD_MMAP_MIN_PAGES 16
+
+/* ---------------------------------------------------------------- */
+/*                              Saving                              */
+/* ---------------------------------------------------------------- */
+
+struct worldSaveState {
+  HM_HierarchicalHeap *heaps;
+  size_t numHeaps;
+  size_t heapsCapacity;
+  struct GC_worldChunk *chunks;
+  size_t numChunks;
+  size_t chunksCapacity;
+  bool ok;
+};
+
+static uint32_t worldHeapIndex(struct worldSaveState *w, HM_HierarchicalHeap hh) {
+  for (size_t i = 0; i < w->numHeaps; i++) {
+    if (w->heaps[i] == hh)
+      return i;
+  }
+
+  /* Worlds are saved at the top level, so every heap must be a root heap
+   * without a collection in progress. */
+  if (0 != HM_HH_getDepth(hh)
+      || NULL != hh->nextAncestor
+      || NULL != hh->subHeapForCC
+      || CC_UNREG != HM_HH_getConcurrentPack(hh)->ccstate)
+  {
+    w->ok = FALSE;
+  }
+
+  if (w->numHeaps == w->heapsCapacity) {
+    w->heapsCapacity = 2 * w->heapsCapacity + 1;
+    w->heaps = realloc(w->heaps, w->heapsCapacity * sizeof(HM_HierarchicalHeap));
+  }
+  w->heaps[w->numHeaps] = hh;
+  return w->numHeaps++;
+}
+
+static void worldAddChunks(
+  GC_state s,
+  struct worldSaveState *w,
+  uint32_t heap,
+  HM_chunkList list)
 {
-  DIE("GC_saveWorld is unsupported");
+  for (HM_chunk chunk = HM_getChunkListFirstChunk(list);
+       NULL != chunk;
+       chunk = chunk->nextChunk)
+  {
+    if (w->numChunks == w->chunksCapacity) {
+      w->chunksCapacity = 2 * w->chunksCapacity + 1;
+      w->chunks = realloc(w->chunks, w->chunksCapacity * sizeof(struct GC_worldChunk));
+    }
+    struct GC_worldChunk *wc = &(w->chunks[w->numChunks++]);
+    wc->chunk = (pointer)chunk;
+    wc->size = HM_getChunkSize(chunk);
+    wc->used = HM_getChunkFrontier(chunk) - HM_getChunkStart(chunk);
+    wc->imageOffset = 0;
+    wc->heap = heap;
+    wc->startGap = chunk->startGap;
+    wc->mightContainMultipleObjects = chunk->mightContainMultipleObjects;
+
+    /* Threads reachable from this heap bring their own heaps along. */
+    pointer p = HM_getChunkStart(chunk);
+    pointer frontier = HM_getChunkFrontier(chunk);
+    while (p < frontier) {
+      p = advanceToObjectData(s, p);
+      if (GC_THREAD_HEADER == getHeader(p)) {
+        GC_thread thread = (GC_thread)(p + offsetofThread(s));
+        if (NULL != thread->hierarchicalHeap)
+          worldHeapIndex(w, thread->hierarchicalHeap);
+      }
+      p += sizeofObjectNoMetaData(s, p);
+    }
+  }
+}
+
+static bool writeAll(FILE *f, const void *buf, size_t size) {
+  return fwrite(buf, 1, size, f) == size;
+}
+
+static bool writePadding(FILE *f, size_t pageSize) {
+  long pos = ftell(f);
+  if (pos < 0)
+    return FALSE;
+  size_t pad = align((size_t)pos, pageSize) - (size_t)pos;
+  return 0 == pad || 0 == fseek(f, pad, SEEK_CUR);
+}
+
+static bool saveWorldToFILE(GC_state s, FILE *f, uint32_t atomicState) {
+  struct worldSaveState w = {NULL, 0, 0, NULL, 0, 0, TRUE};
+  struct GC_worldHeader header;
+  size_t pageSize = GC_pageSize();
+  bool ok = FALSE;
+
+  GC_thread thread = getThreadCurrent(s);
+  worldHeapIndex(&w, thread->hierarchicalHeap);
+
+  /* worldAddChunks may discover more heaps as it goes. */
+  for (size_t i = 0; i < w.numHeaps; i++) {
+    HM_HierarchicalHeap hh = w.heaps[i];
+    worldAddChunks(s, &w, i, HM_HH_getChunkList(hh));
+    if (NULL != hh->subHeapCompletedCC)
+      worldAddChunks(s, &w, i, HM_HH_getChunkList(hh->subHeapCompletedCC));
+  }
+  if (!w.ok) {
+    errno = ENOTSUP;
+    goto done;
+  }
+
+  memset(&header, 0, sizeof(header));
+  snprintf(header.banner, sizeof(header.banner),
+           "Heap file created by MPL.\n");
+  header.magic = s->magic;
+  header.version = GC_WORLD_VERSION;
+  header.blockSize = s->controls->blockSize;
+  header.pageSize = pageSize;
+  header.numHeaps = w.numHeaps;
+  header.numChunks = w.numChunks;
+  header.staticHeaps = s->staticHeaps;
+  header.atomicState = atomicState;
+  header.callFromCHandlerThread = s->callFromCHandlerThread;
+  header.currentThread = s->currentThread;
+  header.signalHandlerThread = s->signalHandlerThread;
+  header.wsQueue = s->wsQueue;
+  header.wsQueueTop = s->wsQueueTop;
+  header.wsQueueBot = s->wsQueueBot;
+
+  /* The header and chunk table are written again once the offsets are
+   * known. */
+  if (!writeAll(f, &header, sizeof(header))
+      || !writeAll(f, w.chunks, w.numChunks * sizeof(struct GC_worldChunk))
+      || !writeAll(f, w.heaps, w.numHeaps * sizeof(HM_HierarchicalHeap))
+      || !writeAll(f, s->staticHeaps.mutable.start, s->staticHeaps.mutable.size)
+      || !writeAll(f, s->staticHeaps.root.start, s->staticHeaps.root.size)
+      || !writePadding(f, pageSize))
+  {
+    goto done;
+  }
+
+  header.chunkImagesOffset = ftell(f);
+  for (size_t i = 0; i < w.numChunks; i++) {
+    struct GC_worldChunk *wc = &(w.chunks[i]);
+    HM_chunk chunk = (HM_chunk)wc->chunk;
+    wc->imageOffset = ftell(f);
+    if (!writeAll(f, wc->chunk, HM_getChunkFrontier(chunk) - wc->chunk)
+        || !writePadding(f, pageSize))
+    {
+      goto done;
+    }
+  }
+
+  header.globalsOffset = ftell(f);
+  /* Writing the globals also extends the file over the padding of the last
+   * chunk image, so that all of it can be mapped. */
+  if (0 != (*(s->saveGlobals))(f))
+    goto done;
+
+  if (0 != fseek(f, 0, SEEK_SET)
+      || !writeAll(f, &header, sizeof(header))
+      || !writeAll(f, w.chunks, w.numChunks * sizeof(struct GC_worldChunk)))
+  {
+    goto done;
+  }
+
+  ok = TRUE;
+
+done:
+  free(w.heaps);
+  free(w.chunks);
+  return ok;
+}
+
+void GC_saveWorld (GC_state s, NullString8_t fileName) {
+  FILE *f;
+
+  getStackCurrent(s)->used = sizeofGCStateCurrentStackUsed(s);
+  getThreadCurrent(s)->exnStack = s->exnStack;
+  HM_HH_updateValues(getThreadCurrent(s), s->frontier);
+  /* The clone resumes as if returning from this call, so it gets the
+   * atomic state of the caller. */
+  uint32_t atomicState = s->atomicState;
+  beginAtomic(s);
+  HM_HH_flushRememberBuffer(s);
+  s->writeBarrierLevelHead = NULL;
+
+  s->saveWorldStatus = FALSE;
+
+  if (s->numberOfProcs > 1
+      || 0 != getThreadCurrent(s)->currentDepth)
+  {
+    errno = ENOTSUP;
+    goto done;
+  }
+
+  f = fopen((const char*)fileName, "wb");
+  if (NULL == f)
+    goto done;
+  if (!saveWorldToFILE(s, f, atomicState)) {
+    fclose(f);
+    goto done;
+  }
+  if (0 != fclose(f))
+    goto done;
+
+  s->saveWorldStatus = TRUE;
+
+done:
+  endAtomic(s);
 }
 
 C_Errno_t(Bool_t) GC_getSaveWorldStatus (GC_state s) {
   return (Bool_t)(s->saveWorldStatus);
 }
+
+/* ---------------------------------------------------------------- */
+/*                             Loading                              */
+/* ---------------------------------------------------------------- */
+
+struct worldChunkMapping {
+  pointer from;
+  size_t size;
+  HM_chunk to;
+};
+
+struct worldLoadState {
+  struct GC_worldHeader *header;
+  /* sorted by saved address */
+  struct worldChunkMapping *chunks;
+  size_t numChunks;
+  HM_HierarchicalHeap *oldHeaps;
+  HM_HierarchicalHeap *newHeaps;
+};
+
+static int compareWorldChunkMappings(const void *a, const void *b) {
+  const struct worldChunkMapping *ca = a, *cb = b;
+  return (ca->from > cb->from) - (ca->from < cb->from);
+}
+
+static pointer translateStaticPointer(
+  struct GC_staticHeap *from,
+  struct GC_staticHeap *to,
+  pointer p,
+  bool *found)
+{
+  if (from->start <= p && p <= from->start + from->size) {
+    *found = TRUE;
+    return to->start + (p - from->start);
+  }
+  return p;
+}
+
+static pointer translateWorldPointer(
+  GC_state s,
+  struct worldLoadState *w,
+  pointer p)
+{
+  struct GC_staticHeaps *old = &(w->header->staticHeaps);
+  bool found = FALSE;
+
+  if (NULL == p)
+    return p;
+
+  p = translateStaticPointer(&(old->immutable), &(s->staticHeaps.immutable), p, &found);
+  if (found) return p;
+  p = translateStaticPointer(&(old->mutable), &(s->staticHeaps.mutable), p, &found);
+  if (found) return p;
+  p = translateStaticPointer(&(old->root), &(s->staticHeaps.root), p, &found);
+  if (found) return p;
+
+  size_t lo = 0;
+  size_t hi = w->numChunks;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    struct worldChunkMapping *m = &(w->chunks[mid]);
+    if (p < m->from)
+      hi = mid;
+    else if (p >= m->from + m->size)
+      lo = mid + 1;
+    else
+      return (pointer)(m->to) + (p - m->from);
+  }
+
+  DIE("world contains dangling pointer "FMTPTR, (uintptr_t)p);
+}
+
+static void translateWorldObjptr(
+  GC_state s,
+  objptr *opp,
+  objptr op,
+  void *env)
+{
+  pointer p = objptrToPointer(op, NULL);
+  *opp = pointerToObjptr(translateWorldPointer(s, env, p), NULL);
+}
+
+static void translateWorldRoot(GC_state s, struct worldLoadState *w, objptr *opp) {
+  struct GC_foreachObjptrClosure f = {.fun = translateWorldObjptr, .env = w};
+  callIfIsObjptr(s, &f, opp);
+}
+
+static void translateWorldThread(
+  GC_state s,
+  struct worldLoadState *w,
+  GC_thread thread)
+{
+  HM_HierarchicalHeap hh = thread->hierarchicalHeap;
+  thread->hierarchicalHeap = NULL;
+  for (size_t i = 0; NULL != hh && i < w->header->numHeaps; i++) {
+    if (w->oldHeaps[i] == hh)
+      thread->hierarchicalHeap = w->newHeaps[i];
+  }
+
+  if (NULL != thread->currentChunk) {
+    thread->currentChunk =
+      (HM_chunk)translateWorldPointer(s, w, (pointer)thread->currentChunk);
+  }
+
+  thread->currentProcNum = -1;
+#ifdef DETECT_ENTANGLEMENT
+  thread->decheckState = DECHECK_BOGUS_TID;
+#endif
+}
+
+static void translateWorldChunk(GC_state s, struct worldLoadState *w, HM_chunk chunk) {
+  struct GC_foreachObjptrClosure f = {.fun = translateWorldObjptr, .env = w};
+  pointer p = HM_getChunkStart(chunk);
+  pointer frontier = HM_getChunkFrontier(chunk);
+
+  while (p < frontier) {
+    p = advanceToObjectData(s, p);
+    if (GC_THREAD_HEADER == getHeader(p))
+      translateWorldThread(s, w, (GC_thread)(p + offsetofThread(s)));
+    p = foreachObjptrInObject(s, p, &trueObjptrPredicateClosure, &f, FALSE);
+  }
+}
+
+/* The number of pages of a chunk image, starting at chunk-relative offset
+ * *firstPage, to map from the world file rather than read, or 0 to read the
+ * whole image. Both the allocation of the chunk and loadWorldChunk go by
+ * this, so a mapping only ever replaces a whole megablock of its own, never
+ * part of a superblock. Once freed, such a megablock is pooled or unmapped
+ * like any other (see freeMegaBlock). Decommitting it brings back the file
+ * contents rather than zeros, which is fine: only fresh megablocks (see
+ * allocateFreshBlocks) are assumed to be zero, and those never come from the
+ * pools. */
+static size_t worldChunkMappedPages(
+  GC_state s,
+  struct GC_worldChunk *wc,
+  size_t *firstPage)
+{
+  size_t pageSize = GC_pageSize();
+  /* chunk-relative offsets of the objects */
+  size_t from = sizeof(struct HM_chunk) + wc->startGap;
+  size_t to = from + wc->used;
+  *firstPage = align(from, pageSize);
+  size_t numPages = (align(to, pageSize) - *firstPage) / pageSize;
+
+  if (numPages < WORLD_MMAP_MIN_PAGES)
+    return 0;
+
+  size_t numBlocks = align(to, HM_BLOCK_SIZE) / HM_BLOCK_SIZE;
+  if ((size_t)computeSizeClass(numBlocks) < s->controls->superblockThreshold)
+    return 0;
+
+  return numPages;
+}
+
+static void loadWorldChunk(
+  GC_state s,
+  FILE *f,
+  struct GC_worldChunk *wc,
+  HM_chunk chunk)
+{
+  size_t pageSize = GC_pageSize();
+  pointer start = HM_getChunkStart(chunk);
+  /* chunk-relative offsets of the objects */
+  size_t from = start - (pointer)chunk;
+  size_t to = from + wc->used;
+  size_t firstPage;
+  size_t numPages = worldChunkMappedPages(s, wc, &firstPage);
+  assert(from == sizeof(struct HM_chunk) + wc->startGap);
+
+  if (numPages > 0) {
+    void *res =
+      mmap((pointer)chunk + firstPage, numPages * pageSize,
+           PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+           fileno(f), wc->imageOffset + firstPage);
+    if (MAP_FAILED == res)
+      diee("Unable to map world chunk.");
+    to = firstPage;
+  }
+
+  if (from < to) {
+    fseek_safe(f, wc->imageOffset + from, SEEK_SET);
+    fread_safe(start, 1, to - from, f);
+  }
+}
+
+void loadWorldFromFileName (GC_state s, const char *fileName) {
+  struct GC_worldHeader header;
+  struct worldLoadState w;
+  FILE *f;
+
+  if (s->numberOfProcs > 1)
+    die("Worlds can only be loaded on one processor.");
+
+  f = fopen_safe(fileName, "rb");
+  fread_safe(&header, sizeof(header), 1, f);
+  unless (s->magic == header.magic)
+    die("Invalid world: wrong magic number.");
+  unless (GC_WORLD_VERSION == header.version)
+    die("Invalid world: unsupported version.");
+  unless (s->controls->blockSize == header.blockSize
+          && GC_pageSize() == header.pageSize)
+    die("Invalid world: saved with block-size %"PRIu64", but block-size is %zu.",
+        header.blockSize, s->controls->blockSize);
+  unless (s->staticHeaps.mutable.size == header.staticHeaps.mutable.size
+          && s->staticHeaps.root.size == header.staticHeaps.root.size)
+    die("Invalid world: static heaps do not match.");
+
+  struct GC_worldChunk *saved =
+    malloc_safe(header.numChunks * sizeof(struct GC_worldChunk));
+  w.header = &header;
+  w.numChunks = header.numChunks;
+  w.chunks = malloc_safe(w.numChunks * sizeof(struct worldChunkMapping));
+  w.oldHeaps = malloc_safe(header.numHeaps * sizeof(HM_HierarchicalHeap));
+  w.newHeaps = malloc_safe(header.numHeaps * sizeof(HM_HierarchicalHeap));
+  fread_safe(saved, sizeof(struct GC_worldChunk), w.numChunks, f);
+  fread_safe(w.oldHeaps, sizeof(HM_HierarchicalHeap), header.numHeaps, f);
+  fread_safe(s->staticHeaps.mutable.start, 1, s->staticHeaps.mutable.size, f);
+  fread_safe(s->staticHeaps.root.start, 1, s->staticHeaps.root.size, f);
+
+  for (size_t i = 0; i < header.numHeaps; i++)
+    w.newHeaps[i] = HM_HH_new(s, 0);
+
+  /* Allocate and fill the chunks, in their original order within each heap.
+   * Images that will be mapped get fresh blocks, since their pages are
+   * replaced by the mapping anyway (see worldChunkMappedPages). */
+  size_t bytesLoaded = 0;
+  for (size_t i = 0; i < w.numChunks; i++) {
+    struct GC_worldChunk *wc = &(saved[i]);
+    HM_HierarchicalHeap hh = w.newHeaps[wc->heap];
+    size_t bytes = wc->startGap + wc->used;
+    size_t firstPage;
+    HM_chunk chunk =
+      (worldChunkMappedPages(s, wc, &firstPage) > 0)
+      ? HM_allocateFreshChunk(HM_HH_getChunkList(hh), bytes)
+      : HM_allocateChunkWithPurpose(HM_HH_getChunkList(hh), bytes, BLOCK_FOR_HEAP_CHUNK);
+    if (wc->startGap > 0)
+      HM_shiftChunkStart(chunk, wc->startGap);
+    chunk->levelHead = HM_HH_getUFNode(hh);
+    chunk->mightContainMultipleObjects = wc->mightContainMultipleObjects;
+    chunk->decheckState = DECHECK_BOGUS_TID;
+
+    loadWorldChunk(s, f, wc, chunk);
+    HM_updateChunkFrontierInList(
+      HM_HH_getChunkList(hh),
+      chunk,
+      HM_getChunkStart(chunk) + wc->used);
+
+    w.chunks[i].from = wc->chunk;
+    w.chunks[i].size = wc->size;
+    w.chunks[i].to = chunk;
+    bytesLoaded += wc->used;
+  }
+  qsort(w.chunks, w.numChunks, sizeof(struct worldChunkMapping),
+        compareWorldChunkMappings);
+  free(saved);
+
+  fseek_safe(f, header.globalsOffset, SEEK_SET);
+  if (0 != (*(s->loadGlobals))(f))
+    diee("Unable to load globals.");
+  fclose_safe(f);
+
+  /* Translate every objptr and fix up the threads. */
+  struct GC_foreachObjptrClosure translate =
+    {.fun = translateWorldObjptr, .env = &w};
+  foreachObjptrInStaticHeap(s, &(s->staticHeaps.mutable), &translate, FALSE);
+  foreachObjptrInStaticHeap(s, &(s->staticHeaps.root), &translate, FALSE);
+  for (size_t i = 0; i < w.numChunks; i++)
+    translateWorldChunk(s, &w, w.chunks[i].to);
+  for (uint32_t i = 0; i < s->globalsLength; i++)
+    translateWorldRoot(s, &w, &(s->globals[i]));
+
+  s->atomicState = header.atomicState;
+  s->callFromCHandlerThread = header.callFromCHandlerThread;
+  s->currentThread = header.currentThread;
+  s->signalHandlerThread = header.signalHandlerThread;
+  s->wsQueue = header.wsQueue;
+  s->wsQueueTop = header.wsQueueTop;
+  s->wsQueueBot = header.wsQueueBot;
+  translateWorldRoot(s, &w, &(s->callFromCHandlerThread));
+  translateWorldRoot(s, &w, &(s->currentThread));
+  translateWorldRoot(s, &w, &(s->signalHandlerThread));
+  translateWorldRoot(s, &w, &(s->wsQueue));
+  translateWorldRoot(s, &w, &(s->wsQueueTop));
+  translateWorldRoot(s, &w, &(s->wsQueueBot));
+
+  free(w.chunks);
+  free(w.oldHeaps);
+  free(w.newHeaps);
+
+  /* Resume the saved thread, allocating in a new chunk of its heap. */
+  switchToThread(s, s->currentThread);
+  GC_thread thread = getThreadCurrent(s);
+  if (!HM_HH_extend(s, thread, GC_HEAP_LIMIT_SLOP))
+    DIE("Ran out of space for Hierarchical Heap!");
+  s->frontier = HM_HH_getFrontier(thread);
+  s->limitPlusSlop = HM_HH_getLimit(thread);
+  s->limit = s->limitPlusSlop - GC_HEAP_LIMIT_SLOP;
+
+  s->saveWorldStatus = TRUE;
+  s->cumulativeStatistics->bytesAllocated += bytesLoaded;
+  s->lastMajorStatistics->bytesLive = bytesLoaded;
+  decheckInit(s);
+}
@@ -6,7 +6,65 @@
  * See the file MLton-LICENSE for details.
  */
 
+#if (defined (MLTON_GC_INTERNAL_TYPES))
+
+/* A world file is laid out as
+ *
+ *   GC_worldHeader
+ *   GC_worldChunk[numChunks]
+ *   contents of the mutable static heap
+ *   contents of the root static heap
+ *   chunk images, each starting on a page boundary
+ *   globals (see saveGlobals)
+ *
+ * A chunk image is a copy of the chunk from its first byte up to its
+ * frontier, padded to a whole number of pages. Because chunks are
+ * block-aligned, an object lands at the same page offset when the image is
+ * mapped into a new chunk, so large images are mmap'ed rather than read.
+ * The heap is relocated when loaded: every objptr is translated from the
+ * saved chunk (or static heap) it points into to the new one.
+ */
+
+#define GC_WORLD_VERSION 1
+
+struct GC_worldHeader {
+  char banner[64];
+  uint32_t magic; /* s->magic of the executable that saved the world */
+  uint32_t version;
+  uint64_t blockSize;
+  uint64_t pageSize;
+  uint64_t numHeaps;
+  uint64_t numChunks;
+  uint64_t chunkImagesOffset;
+  uint64_t globalsOffset;
+
+  struct GC_staticHeaps staticHeaps;
+
+  uint32_t atomicState;
+  objptr callFromCHandlerThread;
+  objptr currentThread;
+  objptr signalHandlerThread;
+  objptr wsQueue;
+  objptr wsQueueTop;
+  objptr wsQueueBot;
+};
+
+struct GC_worldChunk {
+  pointer chunk; /* address of the chunk when saved */
+  uint64_t size; /* limit - chunk */
+  uint64_t used; /* frontier - start */
+  uint64_t imageOffset;
+  uint32_t heap; /* index of the hierarchical heap it belongs to */
+  uint8_t startGap;
+  bool mightContainMultipleObjects;
+};
+
+#endif /* (defined (MLTON_GC_INTERNAL_TYPES)) */
+
 #if (defined (MLTON_GC_INTERNAL_FUNCS))
+
+void loadWorldFromFileName (GC_state s, const char *fileName);
+
 #endif /* (defined (MLTON_GC_INTERNAL_FUNCS)) */
 
 #if (defined (MLTON_GC_INTERNAL_BASIS))
@@ -51,6 +51,7 @@ int main (__attribute__ ((unused)) int argc,
   MkSize (cptrdiff, sizeof(C_Ptrdiff_t));
   MkSize (csize, sizeof(C_Size_t));
   MkSize (header, sizeof(GC_header));
+  MkSize (minAlign, GC_MODEL_MINALIGN);
   MkSize (mplimb, sizeof(C_MPLimb_t));
   MkSize (normalMetaData, GC_NORMAL_METADATA_SIZE);
   MkSize (objptr, sizeof(objptr));
@@ -58,6 +59,7 @@ int main (__attribute__ ((unused)) int argc,
   MkSize (sequenceMetaData, GC_SEQUENCE_METADATA_SIZE);
 
   MkGCFieldOffset (atomicState);
+  MkGCFieldOffset (blockMask);
   MkGCFieldOffset (exnStack);
   MkGCFieldOffset (frontier);
   MkGCFieldOffset (limit);
@@ -67,6 +69,7 @@ int main (__attribute__ ((unused)) int argc,
   MkGCFieldOffset (stackBottom);
   MkGCFieldOffset (stackLimit);
   MkGCFieldOffset (stackTop);
+  MkGCFieldOffset (writeBarrierLevelHead);
 
   MkStrConst (MLton_Platform_Arch_host);
   MkStrConst (MLton_Platform_OS_host);
@@ -51,6 +51,21 @@
 #error HAS_TIME_PROFILING not defined
 #endif
 
+/* With HAS_THREAD_CPU_TIMERS, time profiling gives each processor its own
+ * CPU-clock timer (timer_create with SIGEV_THREAD_ID).  Otherwise, it uses a
+ * single process-wide ITIMER_PROF.
+ */
+#ifndef HAS_THREAD_CPU_TIMERS
+#define HAS_THREAD_CPU_TIMERS FALSE
+#endif
+
+/* With HAS_FUTEX, idle processors park on a futex and are woken when work
+ * appears.  Otherwise, they sleep until their timeout expires.
+ */
+#ifndef HAS_FUTEX
+#define HAS_FUTEX FALSE
+#endif
+
 #ifndef EXECVP
 #define EXECVP execvp
 #endif
@@ -139,10 +154,38 @@ PRIVATE void *GC_mmapAnonFlags_safe_protect (void *start, size_t length,
                                              size_t dead_high);
 PRIVATE void *GC_mremap (void *start, size_t oldLength, size_t newLength);
 PRIVATE void GC_release (void *base, size_t length);
+/* GC_adviseHugePages asks for a region to be backed by huge pages.
+ * GC_decommit lets the OS reclaim the memory of a region, which stays mapped
+ * but whose contents become undefined.
+ */
+PRIVATE void GC_adviseHugePages (void *base, size_t length);
+PRIVATE void GC_decommit (void *base, size_t length);
 
 PRIVATE size_t GC_pageSize (void);
 PRIVATE uintmax_t GC_physMem (void);
 
+/* GC_numaNodeOfCPU returns the NUMA node of a CPU, or 0 if unknown. */
+PRIVATE uint32_t GC_numaNodeOfCPU (uint32_t cpu);
+
+/* GC_cpuQuota returns the cgroup CPU quota of the process in whole CPUs
+ * (rounded up), or 0 if there is none or it is unknown.
+ */
+PRIVATE uint32_t GC_cpuQuota (void);
+
+/* Hardware performance counters of the calling thread.
+ * GC_perfCounterOpen starts counting one of the GC_PERF_* events (see
+ * gc/perf-counters.h), as a member of the group led by groupFd, or as a new
+ * group leader if groupFd is -1. It returns a file descriptor, or -1 if the
+ * event is unavailable. GC_perfCounterReadGroup reads the n counters of a
+ * group, in the order in which they were opened, and sets *multiplexed if
+ * the group was not counting all the time; the counts are then estimates,
+ * scaled up to the whole time.
+ */
+PRIVATE int GC_perfCounterOpen (uint32_t event, int groupFd);
+PRIVATE bool GC_perfCounterReadGroup (int leaderFd, uint32_t n, uint64_t *values,
+                                      bool *multiplexed);
+PRIVATE void GC_perfCounterClose (int fd);
+
 PRIVATE void GC_setCygwinUseMmap (bool b);
 
 PRIVATE void GC_diskBack_close (void *data);
@@ -4,9 +4,13 @@
 #include <sys/procfs.h>
 #include <sys/vminfo.h>
 
+#include "platform/cgroup.none.c"
 #include "platform/diskBack.unix.c"
+#include "platform/madvise.c"
 #include "platform/mmap-protect.c"
 #include "platform/nonwin.c"
+#include "platform/numa.none.c"
+#include "platform/perf.none.c"
 #include "platform/recv.nonblock.c"
 #include "platform/use-mmap.c"
 
@@ -0,0 +1,41 @@
+/* The CPU quota of the cgroup this process runs in, rounded up to whole
+ * CPUs. Reads cpu.max (cgroup v2) or cpu.cfs_quota_us and cpu.cfs_period_us
+ * (cgroup v1). Returns 0 if there is no quota or it can't be determined.
+ */
+static bool readCgroupLine (const char *path, char *buf, size_t size) {
+        FILE *f;
+        bool ok;
+
+        f = fopen (path, "r");
+        if (NULL == f)
+                return FALSE;
+        ok = (NULL != fgets (buf, size, f));
+        fclose (f);
+        return ok;
+}
+
+static uint32_t quotaToCPUs (long long quota, long long period) {
+        if (quota <= 0 || period <= 0)
+                return 0;
+        return (uint32_t)((quota + period - 1) / period);
+}
+
+uint32_t GC_cpuQuota (void) {
+        char buf[64];
+        long long quota, period;
+
+        if (readCgroupLine ("/sys/fs/cgroup/cpu.max", buf, sizeof (buf))) {
+                if (2 == sscanf (buf, "%lld %lld", &quota, &period))
+                        return quotaToCPUs (quota, period);
+                /* "max <period>" */
+                return 0;
+        }
+
+        if (readCgroupLine ("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", buf, sizeof (buf))
+            && 1 == sscanf (buf, "%lld", &quota)
+            && readCgroupLine ("/sys/fs/cgroup/cpu/cpu.cfs_period_us", buf, sizeof (buf))
+            && 1 == sscanf (buf, "%lld", &period))
+                return quotaToCPUs (quota, period);
+
+        return 0;
+}
@@ -0,0 +1,3 @@
+uint32_t GC_cpuQuota (void) {
+        return 0;
+}
@@ -2,7 +2,11 @@
 
 #include "platform.h"
 
+#include "platform/cgroup.none.c"
+#include "platform/madvise.c"
 #include "platform/mmap.c"
+#include "platform/numa.none.c"
+#include "platform/perf.none.c"
 #if not HAS_MSG_DONTWAIT
 #include "platform/recv.nonblock.c"
 #endif
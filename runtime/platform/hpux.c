@@ -7,9 +7,13 @@
 
 #define MAP_ANON MAP_ANONYMOUS
 
+#include "platform/cgroup.none.c"
 #include "platform/diskBack.unix.c"
+#include "platform/madvise.c"
 #include "platform/mmap-protect.c"
 #include "platform/nonwin.c"
+#include "platform/numa.none.c"
+#include "platform/perf.none.c"
 #include "platform/recv.nonblock.c"
 #include "platform/setenv.putenv.c"
 #include "platform/use-mmap.c"
@@ -2,10 +2,14 @@
 
 #include "platform.h"
 
+#include "platform/cgroup.none.c"
 #include "platform/diskBack.unix.c"
 #include "platform/displayMem.proc.c"
+#include "platform/madvise.c"
 #include "platform/mmap-protect.c"
 #include "platform/nonwin.c"
+#include "platform/numa.none.c"
+#include "platform/perf.none.c"
 #include "platform/use-mmap.c"
 #include "platform/sysconf.c"
 #include "platform/mremap.c"
@@ -3,10 +3,14 @@
 
 #include "platform.h"
 
+#include "platform/cgroup.linux.c"
 #include "platform/diskBack.unix.c"
 #include "platform/displayMem.proc.c"
+#include "platform/madvise.c"
 #include "platform/mmap-protect.c"
 #include "platform/nonwin.c"
+#include "platform/numa.sysfs.c"
+#include "platform/perf.linux.c"
 #include "platform/use-mmap.c"
 
 void *GC_mremap (void *start, size_t oldLength, size_t newLength) {
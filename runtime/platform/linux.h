@@ -28,6 +28,8 @@
 #include <sys/utsname.h>
 #include <sys/wait.h>
 #include <sys/sysinfo.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include <syslog.h>
 #include <termios.h>
 #include <utime.h>
@@ -47,6 +49,8 @@
 #endif
 #define HAS_SPAWN FALSE
 #define HAS_TIME_PROFILING TRUE
+#define HAS_THREAD_CPU_TIMERS TRUE
+#define HAS_FUTEX TRUE
 
 #define MLton_Platform_OS_host "linux"
 
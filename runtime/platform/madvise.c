@@ -0,0 +1,23 @@
+/* Both of these are only hints; failures are ignored. */
+
+void GC_adviseHugePages (void *base, size_t length) {
+#if (defined (MADV_HUGEPAGE))
+        madvise (base, length, MADV_HUGEPAGE);
+#else
+        (void)base;
+        (void)length;
+#endif
+}
+
+void GC_decommit (void *base, size_t length) {
+#if (defined (MADV_FREE))
+        if (0 == madvise (base, length, MADV_FREE))
+                return;
+#endif
+#if (defined (MADV_DONTNEED))
+        madvise (base, length, MADV_DONTNEED);
+#else
+        (void)base;
+        (void)length;
+#endif
+}
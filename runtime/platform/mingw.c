@@ -2,6 +2,10 @@
 
 #include "platform.h"
 
+#include "platform/cgroup.none.c"
+#include "platform/madvise.c"
+#include "platform/numa.none.c"
+#include "platform/perf.none.c"
 #include "platform/windows.c"
 #include "platform/mremap.c"
 
@@ -0,0 +1,3 @@
+uint32_t GC_numaNodeOfCPU (__attribute__ ((unused)) uint32_t cpu) {
+        return 0;
+}
@@ -0,0 +1,26 @@
+#include <dirent.h>
+
+/* The NUMA node of a CPU is given by the `nodeN` entry in its sysfs
+ * directory. Returns 0 if this can't be determined (e.g., a kernel without
+ * NUMA support).
+ */
+uint32_t GC_numaNodeOfCPU (uint32_t cpu) {
+        char path[64];
+        DIR *dir;
+        struct dirent *entry;
+        unsigned int node;
+
+        snprintf (path, sizeof (path), "/sys/devices/system/cpu/cpu%" PRIu32, cpu);
+        dir = opendir (path);
+        if (NULL == dir)
+                return 0;
+
+        node = 0;
+        while (NULL != (entry = readdir (dir))) {
+                if (1 == sscanf (entry->d_name, "node%u", &node))
+                        break;
+                node = 0;
+        }
+        closedir (dir);
+        return (uint32_t)node;
+}
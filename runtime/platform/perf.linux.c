@@ -0,0 +1,76 @@
+#include <linux/perf_event.h>
+
+/* Counters are per-thread (pid 0, any CPU) and count user space only, so
+ * that they work with the default perf_event_paranoid setting. Every
+ * counter is read together with its group, through the leader. When there
+ * are more counters than the PMU has, the kernel multiplexes the groups, and
+ * a group only counts part of the time; the counts are then scaled up by the
+ * time the group was enabled over the time it was running.
+ */
+int GC_perfCounterOpen (uint32_t event, int groupFd) {
+        struct perf_event_attr attr;
+
+        memset (&attr, 0, sizeof (attr));
+        attr.size = sizeof (attr);
+        switch (event) {
+        case GC_PERF_CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+        case GC_PERF_INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+        case GC_PERF_CACHE_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+        case GC_PERF_DTLB_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB
+                        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+        default:
+                return -1;
+        }
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP
+                | PERF_FORMAT_TOTAL_TIME_ENABLED
+                | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return (int)syscall (__NR_perf_event_open, &attr, 0, -1, groupFd,
+                             PERF_FLAG_FD_CLOEXEC);
+}
+
+bool GC_perfCounterReadGroup (int leaderFd, uint32_t n, uint64_t *values,
+                              bool *multiplexed) {
+        /* nr, time_enabled, time_running, then the values */
+        uint64_t buf[3 + GC_PERF_NUM_EVENTS];
+        ssize_t expected;
+        uint64_t enabled, running;
+
+        if (n > GC_PERF_NUM_EVENTS)
+                return FALSE;
+        expected = (ssize_t)((3 + n) * sizeof (uint64_t));
+        if (read (leaderFd, buf, sizeof (buf)) < expected || buf[0] != n)
+                return FALSE;
+        enabled = buf[1];
+        running = buf[2];
+        *multiplexed = running < enabled;
+        for (uint32_t i = 0; i < n; i++) {
+                if (0 == running)
+                        values[i] = 0;
+                else if (running < enabled)
+                        values[i] = (uint64_t)((double)buf[3 + i]
+                                               * ((double)enabled / (double)running));
+                else
+                        values[i] = buf[3 + i];
+        }
+        return TRUE;
+}
+
+void GC_perfCounterClose (int fd) {
+        close (fd);
+}
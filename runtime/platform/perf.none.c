@@ -0,0 +1,14 @@
+int GC_perfCounterOpen (__attribute__ ((unused)) uint32_t event,
+                        __attribute__ ((unused)) int groupFd) {
+        return -1;
+}
+
+bool GC_perfCounterReadGroup (__attribute__ ((unused)) int leaderFd,
+                              __attribute__ ((unused)) uint32_t n,
+                              __attribute__ ((unused)) uint64_t *values,
+                              __attribute__ ((unused)) bool *multiplexed) {
+        return FALSE;
+}
+
+void GC_perfCounterClose (__attribute__ ((unused)) int fd) {
+}
@@ -60,6 +60,10 @@ enum EventKind {
   EVENT_MERGED_HEAP           = 32,
 
   EVENT_COPY                  = 33,
+
+  /* Written by the trace writer rather than traced; see below. */
+  EVENT_TRACE_CLOCK           = 34,
+  EVENT_TRACE_DROPPED         = 35,
 };
 
 #define EventKindCount (sizeof EventKindStrings / sizeof *EventKindStrings)
@@ -85,6 +89,41 @@ struct TraceFileHeader {
   EventInt version;
 };
 
-#define TraceCurrentVersion 0x20170419ULL
+#define TraceCurrentVersion 0x20261018ULL
+
+/* An event as recorded in a processor's ring buffer. This is also the layout
+ * of the rings that `mltrace corelog` dumps out of a core file. */
+struct TraceRecord {
+  /* Raw timestamp; TSC ticks on x86, nanoseconds elsewhere. */
+  uint64_t tsc;
+  uint32_t kind;
+  uint32_t proc;
+  EventInt arg1;
+  EventInt arg2;
+  EventInt arg3;
+};
+
+/* On-disk format. A trace file is a sequence of streams, one per processor,
+ * so the files of several processors can simply be concatenated. A stream is
+ *
+ *   TRACE_STREAM_MAGIC  varint(version)  varint(proc)  record*
+ *
+ * and a record is
+ *
+ *   varint(kind << 3 | argmask)  zigzag-varint(tsc - previous tsc)  varint(arg)*
+ *
+ * where bit i of argmask is set if argument i+1 is nonzero and present.
+ * Varints are LEB128. Kind 0 never appears in a record, so the leading zero
+ * byte of the magic marks the start of the next stream. Readers tell a trace
+ * file from a raw ring dump (a plain array of struct TraceRecord) by whether
+ * it starts with the whole magic.
+ *
+ * EVENT_TRACE_CLOCK records pair a raw timestamp with CLOCK_MONOTONIC
+ * nanoseconds (arg1); readers interpolate between them to convert the raw
+ * timestamps of the other records. EVENT_TRACE_DROPPED says that arg1 events
+ * were lost because the ring was full. */
+#define TRACE_STREAM_MAGIC "\0MLTRACE"
+#define TRACE_STREAM_MAGIC_SIZE 8
+#define TRACE_RECORD_MAX_SIZE (4 * 10 + 5)
 
 #endif  /* TRACE_H */
@@ -7,23 +7,184 @@
 #include <sys/time.h>
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "tracing.h"
 
+/* How often the writer thread drains the rings. */
+#define TRACING_WRITER_PERIOD_NS 10000000L
+
+/* Protects the list of live contexts, and the files and encoder state of
+ * every context on it. */
+static pthread_mutex_t tracingLock = PTHREAD_MUTEX_INITIALIZER;
+static struct TracingContext *tracingContexts = NULL;
+static pthread_once_t tracingWriterOnce = PTHREAD_ONCE_INIT;
+
+static inline void
+TracingGetTimespec(struct timespec *ts)
+{
+#if defined(__APPLE__)
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  ts->tv_sec = tv.tv_sec;
+  ts->tv_nsec = 1000 * tv.tv_usec;
+#elif defined(CLOCK_MONOTONIC_RAW)
+  clock_gettime(CLOCK_MONOTONIC_RAW, ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, ts);
+#endif
+}
+
+static inline uint64_t TracingGetNanoseconds(void) {
+  struct timespec ts;
+  TracingGetTimespec(&ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Assumes an invariant TSC that is synchronized across cores, as on any
+ * recent x86. */
+static inline uint64_t TracingReadClock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return TracingGetNanoseconds();
+#endif
+}
+
+static inline size_t putVarint(unsigned char *buf, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    buf[n++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  buf[n++] = (unsigned char)v;
+  return n;
+}
+
+static void TracingWrite(struct TracingContext *ctx,
+                         const void *buf, size_t size) {
+  if (fwrite(buf, 1, size, ctx->file) < size) {
+    fprintf(stderr, "Tracing: could not write to file\n");
+    exit(1);
+  }
+}
+
+/* Requires the writer lock, or exclusive access to ctx. */
+static void TracingEncode(struct TracingContext *ctx,
+                          const struct TraceRecord *r) {
+  unsigned char buf[TRACE_RECORD_MAX_SIZE];
+  EventInt args[3] = {r->arg1, r->arg2, r->arg3};
+  uint64_t mask = 0;
+  size_t n = 0;
+
+  for (int i = 0; i < 3; i++)
+    if (args[i] != 0)
+      mask |= 1 << i;
+
+  int64_t delta = (int64_t)(r->tsc - ctx->lastTsc);
+  ctx->lastTsc = r->tsc;
+
+  n += putVarint(buf + n, ((uint64_t)r->kind << 3) | mask);
+  n += putVarint(buf + n, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+  for (int i = 0; i < 3; i++)
+    if (args[i] != 0)
+      n += putVarint(buf + n, args[i]);
+
+  TracingWrite(ctx, buf, n);
+}
+
+static void TracingEncodeClock(struct TracingContext *ctx) {
+  struct TraceRecord r;
+  r.tsc = TracingReadClock();
+  r.kind = EVENT_TRACE_CLOCK;
+  r.proc = ctx->id;
+  r.arg1 = TracingGetNanoseconds();
+  r.arg2 = 0;
+  r.arg3 = 0;
+  TracingEncode(ctx, &r);
+}
+
+/* Requires the writer lock, or exclusive access to ctx. */
+static void TracingDrain(struct TracingContext *ctx) {
+  size_t tail = ctx->tail;
+  size_t head = __atomic_load_n(&ctx->head, __ATOMIC_ACQUIRE);
+  size_t dropped = __atomic_load_n(&ctx->dropped, __ATOMIC_RELAXED);
+
+  if (tail == head && dropped == ctx->droppedReported)
+    return;
+
+  for (; tail != head; tail++)
+    TracingEncode(ctx, &ctx->ring[tail & (ctx->capacity - 1)]);
+  __atomic_store_n(&ctx->tail, tail, __ATOMIC_RELEASE);
+
+  if (dropped != ctx->droppedReported) {
+    struct TraceRecord r;
+    r.tsc = TracingReadClock();
+    r.kind = EVENT_TRACE_DROPPED;
+    r.proc = ctx->id;
+    r.arg1 = dropped - ctx->droppedReported;
+    r.arg2 = 0;
+    r.arg3 = 0;
+    TracingEncode(ctx, &r);
+    ctx->droppedReported = dropped;
+  }
+
+  TracingEncodeClock(ctx);
+  fflush(ctx->file);
+}
+
+static void *TracingWriterLoop(void *arg) {
+  (void)arg;
+  struct timespec period = {0, TRACING_WRITER_PERIOD_NS};
+
+  while (1) {
+    nanosleep(&period, NULL);
+    pthread_mutex_lock(&tracingLock);
+    for (struct TracingContext *ctx = tracingContexts;
+         ctx != NULL;
+         ctx = ctx->next)
+    {
+      TracingDrain(ctx);
+    }
+    pthread_mutex_unlock(&tracingLock);
+  }
+
+  return NULL;
+}
+
+static void TracingStartWriter(void) {
+  pthread_t writer;
+  if (pthread_create(&writer, NULL, TracingWriterLoop, NULL) != 0) {
+    fprintf(stderr, "Tracing: could not start writer thread\n");
+    exit(1);
+  }
+  pthread_detach(writer);
+}
+
 struct TracingContext *TracingNewContext(const char *filename,
                                          size_t bufferCapacity,
                                          uint32_t procNumber) {
   struct TracingContext *ctx;
+  size_t capacity = 1;
+
+  while (capacity < bufferCapacity)
+    capacity *= 2;
 
   if ((ctx = malloc(sizeof *ctx)) == NULL) {
     fprintf(stderr, "Tracing: could not allocate context\n");
     exit(1);
   }
 
-  if ((ctx->buffer = calloc(bufferCapacity, sizeof *ctx->buffer)) == NULL) {
+  if ((ctx->ring = calloc(capacity, sizeof *ctx->ring)) == NULL) {
     fprintf(stderr, "Tracing: could not allocate buffer\n");
     exit(1);
   }
@@ -34,8 +195,26 @@ struct TracingContext *TracingNewContext(const char *filename,
   }
 
   ctx->id = procNumber;
-  ctx->capacity = bufferCapacity;
-  ctx->index = 0;
+  ctx->capacity = capacity;
+  ctx->head = 0;
+  ctx->tail = 0;
+  ctx->dropped = 0;
+  ctx->droppedReported = 0;
+  ctx->lastTsc = 0;
+
+  unsigned char header[TRACE_STREAM_MAGIC_SIZE + 2 * 10];
+  size_t n = TRACE_STREAM_MAGIC_SIZE;
+  memcpy(header, TRACE_STREAM_MAGIC, TRACE_STREAM_MAGIC_SIZE);
+  n += putVarint(header + n, TraceCurrentVersion);
+  n += putVarint(header + n, procNumber);
+  TracingWrite(ctx, header, n);
+  TracingEncodeClock(ctx);
+
+  pthread_once(&tracingWriterOnce, TracingStartWriter);
+  pthread_mutex_lock(&tracingLock);
+  ctx->next = tracingContexts;
+  tracingContexts = ctx;
+  pthread_mutex_unlock(&tracingLock);
 
   Trace_(ctx, EVENT_INIT, 0, 0, 0);
 
@@ -49,10 +228,28 @@ void TracingCloseAndFreeContext(struct TracingContext **ctx) {
   /* Mark termination in the log file. */
   Trace_(*ctx, EVENT_FINISH, 0, 0, 0);
 
-  TracingFlushBuffer(*ctx);
+  pthread_mutex_lock(&tracingLock);
+  /* The other processors may never get to close their contexts (e.g. when
+   * this one halts the program), so bring all of them up to date. */
+  for (struct TracingContext **cursor = &tracingContexts;
+       *cursor != NULL;
+       cursor = &((*cursor)->next))
+  {
+    TracingDrain(*cursor);
+  }
+  for (struct TracingContext **cursor = &tracingContexts;
+       *cursor != NULL;
+       cursor = &((*cursor)->next))
+  {
+    if (*cursor == *ctx) {
+      *cursor = (*ctx)->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&tracingLock);
 
   fclose((*ctx)->file);
-  free((*ctx)->buffer);
+  free((*ctx)->ring);
   free(*ctx);
   *ctx = NULL;
 }
@@ -60,32 +257,10 @@ void TracingCloseAndFreeContext(struct TracingContext **ctx) {
 void TracingFlushBuffer(struct TracingContext *ctx) {
   assert(ctx);
   assert(ctx->file);
-  assert(ctx->index <= ctx->capacity);
-
-  size_t nitems = ctx->index;
-
-  if (fwrite(ctx->buffer, sizeof *ctx->buffer, nitems, ctx->file) < nitems) {
-    fprintf(stderr, "Tracing: could not write to file\n");
-    exit(1);
-  }
-
-  ctx->index = 0;
-}
-
-static inline void
-TracingGetTimespec(struct timespec *ts)
-{
-#if defined(__APPLE__)
-  struct timeval tv;
 
-  gettimeofday(&tv, NULL);
-  ts->tv_sec = tv.tv_sec;
-  ts->tv_nsec = 1000 * tv.tv_usec;
-#elif defined(CLOCK_MONOTONIC_RAW)
-  clock_gettime(CLOCK_MONOTONIC_RAW, ts);
-#else
-  clock_gettime(CLOCK_MONOTONIC, ts);
-#endif
+  pthread_mutex_lock(&tracingLock);
+  TracingDrain(ctx);
+  pthread_mutex_unlock(&tracingLock);
 }
 
 void Trace_(struct TracingContext *ctx, int kind,
@@ -93,17 +268,21 @@ void Trace_(struct TracingContext *ctx, int kind,
   if (!ctx)
     return;
 
-  assert(ctx->index < ctx->capacity);
+  size_t head = ctx->head;
+  size_t tail = __atomic_load_n(&ctx->tail, __ATOMIC_ACQUIRE);
+
+  if (head - tail == ctx->capacity) {
+    __atomic_store_n(&ctx->dropped, ctx->dropped + 1, __ATOMIC_RELAXED);
+    return;
+  }
 
-  struct Event ev;
-  ev.kind = kind;
-  ev.argptr = ctx->id;
-  TracingGetTimespec(&ev.ts);
-  ev.arg1 = arg1;
-  ev.arg2 = arg2;
-  ev.arg3 = arg3;
+  struct TraceRecord *r = &ctx->ring[head & (ctx->capacity - 1)];
+  r->tsc = TracingReadClock();
+  r->kind = kind;
+  r->proc = ctx->id;
+  r->arg1 = arg1;
+  r->arg2 = arg2;
+  r->arg3 = arg3;
 
-  ctx->buffer[ctx->index++] = ev;
-  if (ctx->index == ctx->capacity)
-    TracingFlushBuffer(ctx);
+  __atomic_store_n(&ctx->head, head + 1, __ATOMIC_RELEASE);
 }
@@ -11,15 +11,25 @@
 
 #include "trace.h"
 
-/* A structure holding the information required to record tracing
- * messages. Messages are buffered into memory and periodically flushed to disk
- * when the buffer is full. */
+/* A structure holding the information required to record tracing messages.
+ * Each processor appends its events to its own ring buffer without locking,
+ * and a background writer thread periodically drains every ring to its
+ * backing file (see trace.h for the format). When a ring is full, events are
+ * dropped and counted rather than waiting for the writer. */
 struct TracingContext {
-  struct Event *buffer;
+  struct TraceRecord *ring;
+  size_t capacity; /* a power of two */
+  /* Only the owning processor advances head, and only the writer advances
+   * tail; both count events, and are reduced modulo capacity on access. */
+  size_t head;
+  size_t tail;
+  size_t dropped;
   size_t id;
-  size_t index;
-  size_t capacity;
   FILE *file;
+  /* Encoder state, protected by the writer lock. */
+  uint64_t lastTsc;
+  size_t droppedReported;
+  struct TracingContext *next;
 };
 
 /* Allocates a new tracing context and open its backing file. */
@@ -27,13 +37,12 @@ struct TracingContext *TracingNewContext(const char *filename,
                                          size_t bufferCapacity,
                                          uint32_t procNumber);
 
-/* Close a trace file and free the corresponding context. The buffer is
- * flushed. */
+/* Close a trace file and free the corresponding context. The rings of all
+ * contexts are drained first. */
 void TracingCloseAndFreeContext(struct TracingContext **ctx);
 
-/* Flush recent events to the backing file. This function is automatically
- * called by Trace() when the trace buffer is full, so there should be no need
- * to call it manually. */
+/* Drain recent events to the backing file. The writer thread does this
+ * periodically, so there should be no need to call it manually. */
 void TracingFlushBuffer(struct TracingContext *ctx);
 
 /* Add a new log event to the tracing context. */